@@ -0,0 +1,144 @@
+// Times the scan behind `complete <text>`: nudge_contains(task, ?) against the
+// LIKE '%' || ? || '%' it replaced, over generated task text:
+//
+//   cmake -S . -B build -DNUDGE_BUILD_BENCHMARKS=ON
+//   cmake --build build --target nudge_contains_bench
+//   ./build/nudge_contains_bench [tasks]
+//
+// Each needle is counted with SELECT count(*) so both sides scan every row and
+// return the same number, which is checked. The database lives in a scratch
+// HOME and stays in the page cache; only the predicate differs.
+
+#include <array>
+#include <print>
+#include <format>
+#include <random>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <utility>
+#include <filesystem>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "sqlite3.h"
+#include "database.hpp"
+
+namespace {
+  constexpr int DEFAULT_TASKS = 1000000;
+  constexpr int RUNS = 5;
+
+  constexpr std::string_view CONTAINS_QUERY = "SELECT count(*) FROM tasks WHERE nudge_contains(task, ?);";
+  constexpr std::string_view LIKE_QUERY = "SELECT count(*) FROM tasks WHERE task LIKE '%' || ? || '%';";
+  // What every scan pays before either predicate runs: stepping the table,
+  // decoding each row and one built-in function call.
+  constexpr std::string_view BASELINE_QUERY = "SELECT count(*) FROM tasks WHERE length(task) > 0;";
+
+  constexpr std::array<std::string_view, 16> VERBS = {
+    "Buy", "Call", "Email", "Fix", "Review", "Book", "Pay", "Renew",
+    "Clean", "Write", "Send", "Pick up", "Schedule", "Return", "Order", "Plan",
+  };
+  constexpr std::array<std::string_view, 16> OBJECTS = {
+    "milk and eggs", "the dentist", "Alice about the Q3 report", "the leaking kitchen tap",
+    "PR #4182 before standup", "flights to Lisbon", "the electricity bill", "passport",
+    "the garage", "blog post on caching", "invoice to ACME Corp", "dry cleaning",
+    "car service", "library books", "new running shoes", "Mum's birthday dinner",
+  };
+  constexpr std::array<std::string_view, 8> SUFFIXES = {
+    "", " tomorrow", " this week", " before Friday", " (urgent)", " — see notes", " @home", " @work",
+  };
+
+  // A few tasks in other scripts, so the data has the multi-byte text the
+  // UTF-8 path has to fold.
+  constexpr std::array<std::string_view, 4> OTHER_SCRIPTS = {
+    "Réserver le Café Élysée", "Позвонить маме", "Αγορά ψωμιού", "Straße kehren",
+  };
+
+  // Hits from most rows to none, ASCII and not.
+  constexpr std::array<std::string_view, 6> NEEDLES = {
+    "the", "dentist", "INVOICE TO ACME", "before friday", "zebra crossing", "позвонить",
+  };
+
+  void seed(Database& db, int tasks) {
+    std::mt19937 random(42);
+    Transaction transaction(db);
+    auto stmt = db.prepare(Queries::INSERT_TASK_QUERY);
+    for (int i = 0; i < tasks; i++) {
+      const std::string text = random() % 50 == 0
+        ? std::string(OTHER_SCRIPTS[random() % OTHER_SCRIPTS.size()])
+        : std::format("{} {}{}", VERBS[random() % VERBS.size()], OBJECTS[random() % OBJECTS.size()],
+                      SUFFIXES[random() % SUFFIXES.size()]);
+      sqlite3_bind_text(stmt.get(), 1, text.c_str(), -1, SQLITE_TRANSIENT);
+      if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        throw DatabaseException(std::format("Seeding failed: {}", sqlite3_errmsg(db.get())));
+      }
+      sqlite3_reset(stmt.get());
+    }
+    transaction.commit();
+  }
+
+  // Best of RUNS, in milliseconds, and the count the query returned. `needle`
+  // binds the query's parameter, if it has one.
+  std::pair<double, long long> timeCount(Database& db, std::string_view query, std::string_view needle) {
+    auto stmt = db.prepare(query);
+    double best = 0;
+    long long count = 0;
+    for (int i = 0; i < RUNS; i++) {
+      if (sqlite3_bind_parameter_count(stmt.get()) > 0) {
+        sqlite3_bind_text(stmt.get(), 1, needle.data(), static_cast<int>(needle.size()), SQLITE_STATIC);
+      }
+      const auto start = std::chrono::steady_clock::now();
+      if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+        throw DatabaseException(std::format("Count failed: {}", sqlite3_errmsg(db.get())));
+      }
+      const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      count = sqlite3_column_int64(stmt.get(), 0);
+      sqlite3_reset(stmt.get());
+      if (i == 0 || elapsed.count() < best) {
+        best = elapsed.count();
+      }
+    }
+    return {best, count};
+  }
+} // private namespace
+
+int main(int argc, char* argv[]) {
+  const int tasks = argc > 1 ? std::atoi(argv[1]) : DEFAULT_TASKS;
+  if (tasks <= 0) {
+    std::println(stderr, "usage: {} [tasks]", argv[0]);
+    return 2;
+  }
+
+  const auto home = std::filesystem::temp_directory_path() / std::format("nudge-contains-bench-{}", getpid());
+  std::filesystem::create_directories(home / ".nudge");
+  setenv("HOME", home.c_str(), 1);
+
+  int status = 0;
+  try {
+    Database db;
+    database::setupTables(db);
+    seed(db, tasks);
+
+    std::println("SQLite {}, {} tasks, best of {} runs", sqlite3_libversion(), tasks, RUNS);
+    std::println("scan with length(task) > 0: {:.1f} ms", timeCount(db, BASELINE_QUERY, "").first);
+    std::println("{:<18} {:>9} {:>14} {:>14} {:>8}", "needle", "matches", "LIKE", "nudge_contains", "speedup");
+    for (std::string_view needle : NEEDLES) {
+      const auto [like, likeCount] = timeCount(db, LIKE_QUERY, needle);
+      const auto [contains, containsCount] = timeCount(db, CONTAINS_QUERY, needle);
+      std::println("{:<18} {:>9} {:>11.1f} ms {:>11.1f} ms {:>7.2f}x", std::format("\"{}\"", needle), containsCount,
+                   like, contains, like / contains);
+      // LIKE folds ASCII only, so the counts can differ for other scripts.
+      if (likeCount != containsCount && static_cast<unsigned char>(needle.front()) < 0x80) {
+        std::println(stderr, "\"{}\": LIKE counted {} rows, nudge_contains {}", needle, likeCount, containsCount);
+        status = 1;
+      }
+    }
+  } catch (const std::exception& e) {
+    std::println(stderr, "{}", e.what());
+    status = 1;
+  }
+
+  std::filesystem::remove_all(home);
+  return status;
+}
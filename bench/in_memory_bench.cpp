@@ -0,0 +1,171 @@
+// Times whole commands on disk and in in_memory mode, including the load and
+// the write-back, so the two can be compared on the same database:
+//
+//   cmake -S . -B build -DNUDGE_BUILD_BENCHMARKS=ON
+//   cmake --build build --target nudge_in_memory_bench
+//   ./build/nudge_in_memory_bench [tasks...]
+//
+// By default it grows one database through 200k, 1M and 4M tasks (about
+// 50 MiB, 250 MiB and 1 GiB) and runs every command at each size.
+// Each run opens a fresh Database the way the CLI does. "cold" runs first ask
+// the kernel to drop list.db from the page cache (posix_fadvise DONTNEED), which
+// is the case in-memory mode is meant for. HOME points at a scratch directory.
+
+#include <print>
+#include <format>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <filesystem>
+#include <string_view>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sqlite3.h"
+#include "paths.hpp"
+#include "database.hpp"
+
+namespace {
+  constexpr int DEFAULT_TASKS[] = {200000, 1000000, 4000000};
+  constexpr int RUNS = 10;
+  // Past a million tasks every command takes seconds; fewer runs do.
+  constexpr int LARGE_TASKS = 1000000;
+  constexpr int LARGE_RUNS = 3;
+
+  // Steps `query` to the end.
+  void drain(Database& db, std::string_view query) {
+    auto stmt = db.prepare(query);
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+    }
+    if (rc != SQLITE_DONE) {
+      throw DatabaseException(std::format("step: {}", sqlite3_errmsg(db.get())));
+    }
+  }
+
+  void dropFromPageCache() {
+    for (const char* suffix : {"", "-wal"}) {
+      const int fd = open((Paths::dbPath().string() + suffix).c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+      }
+    }
+  }
+
+  void report(std::string_view name, bool cold, int runs, const std::function<void()>& command) {
+    double total = 0;
+    for (int i = 0; i < runs; i++) {
+      if (cold) {
+        dropFromPageCache();
+      }
+      const auto start = std::chrono::steady_clock::now();
+      command();
+      total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::println("{:<40} {:>10.2f} ms/command", std::format("{}{}", name, cold ? ", cold" : ""), total / runs);
+  }
+
+  // A reporting command: both listings and a count.
+  void readAll(bool inMemory) {
+    Database db(Access::ReadOnly, inMemory);
+    drain(db, Queries::SELECT_ALL_TASKS_QUERY);
+    drain(db, Queries::SELECT_COMPLETED_TASK_QUERY);
+    drain(db, Queries::COUNT_PENDING_TASKS_QUERY);
+  }
+
+  // An everyday command: one add, stored back for an in-memory session.
+  void addOne(bool inMemory) {
+    Database db(Access::ReadWrite, inMemory);
+    auto stmt = db.prepare(Queries::INSERT_TASK_QUERY);
+    sqlite3_bind_text(stmt.get(), 1, "benchmark task", -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+      throw DatabaseException(std::format("add: {}", sqlite3_errmsg(db.get())));
+    }
+    if (!database::writeBack(db)) {
+      throw DatabaseException("write-back failed");
+    }
+  }
+
+  void step(Database& db, StatementCache::Lease& stmt, std::string_view what) {
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+    }
+    if (rc != SQLITE_DONE) {
+      throw DatabaseException(std::format("{}: {}", what, sqlite3_errmsg(db.get())));
+    }
+    sqlite3_reset(stmt.get());
+  }
+
+  // Adds tasks `from` to `to`, completing every tenth so both listings have
+  // rows, and checkpoints so the whole database is in list.db.
+  void seed(int from, int to) {
+    Database db;
+    database::setupTables(db);
+    Transaction transaction(db);
+    auto insert = db.prepare(Queries::INSERT_TASK_QUERY);
+    auto complete = db.prepare(Queries::COMPLETE_TASK_BY_ID_QUERY);
+    for (int i = from; i < to; i++) {
+      const std::string text = std::format("task {} buy milk and call {}", i, i % 97);
+      sqlite3_bind_text(insert.get(), 1, text.c_str(), -1, SQLITE_TRANSIENT);
+      step(db, insert, "seed");
+      if (i % 10 == 9) {
+        sqlite3_bind_int64(complete.get(), 1, sqlite3_last_insert_rowid(db.get()));
+        step(db, complete, "seed");
+      }
+    }
+    transaction.commit();
+    database::execOrThrow(db, "PRAGMA wal_checkpoint(TRUNCATE);");
+  }
+} // private namespace
+
+int main(int argc, char* argv[]) {
+  std::vector<int> sizes(std::begin(DEFAULT_TASKS), std::end(DEFAULT_TASKS));
+  if (argc > 1) {
+    sizes.clear();
+    for (int i = 1; i < argc; i++) {
+      sizes.push_back(std::atoi(argv[i]));
+    }
+  }
+  if (std::ranges::any_of(sizes, [](int tasks) { return tasks <= 0; })) {
+    std::println(stderr, "usage: {} [tasks...]", argv[0]);
+    return 2;
+  }
+  std::ranges::sort(sizes);
+
+  const auto home = std::filesystem::temp_directory_path() / std::format("nudge-in-memory-bench-{}", getpid());
+  std::filesystem::create_directories(home / ".nudge");
+  setenv("HOME", home.c_str(), 1);
+
+  int status = 0;
+  try {
+    int seeded = 0;
+    for (int tasks : sizes) {
+      seed(seeded, tasks);
+      seeded = tasks;
+
+      const int runs = tasks > LARGE_TASKS ? LARGE_RUNS : RUNS;
+      std::error_code ec;
+      std::println("SQLite {}, {} tasks, {:.1f} MiB, {} runs", sqlite3_libversion(), tasks,
+                   static_cast<double>(std::filesystem::file_size(Paths::dbPath(), ec)) / (1 << 20), runs);
+      for (bool cold : {false, true}) {
+        report("list + count, on disk", cold, runs, [] { readAll(false); });
+        report("list + count, in memory", cold, runs, [] { readAll(true); });
+        report("add + write-back, on disk", cold, runs, [] { addOne(false); });
+        report("add + write-back, in memory", cold, runs, [] { addOne(true); });
+      }
+      std::println("");
+    }
+  } catch (const std::exception& e) {
+    std::println(stderr, "{}", e.what());
+    status = 1;
+  }
+
+  std::filesystem::remove_all(home);
+  return status;
+}
@@ -0,0 +1,167 @@
+// Runs Nudge's own queries against whichever SQLite this program is linked
+// with, so the tuned nudge_sqlite library can be compared with the untuned
+// amalgamation (nudge_sqlite_bench vs nudge_sqlite_bench_untuned):
+//
+//   cmake -S . -B build -DNUDGE_BUILD_BENCHMARKS=ON
+//   cmake --build build --target nudge_sqlite_bench nudge_sqlite_bench_untuned
+//   ./build/nudge_sqlite_bench [tasks]
+//
+// The database is a scratch file in the temporary directory, migrated to the
+// current schema and run in WAL mode with synchronous = NORMAL like the CLI.
+
+#include <print>
+#include <format>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <filesystem>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "sqlite3.h"
+#include "database.hpp"
+
+namespace {
+  constexpr int DEFAULT_TASKS = 100000;
+  constexpr int SINGLE_ADDS = 2000;
+  constexpr int LIST_REPEATS = 20;
+  constexpr int COUNT_REPEATS = 20000;
+  constexpr int COMPLETIONS = 2000;
+  constexpr int SEARCHES = 500;
+
+  [[noreturn]] void fail(sqlite3* db, std::string_view what) {
+    std::println(stderr, "{}: {}", what, sqlite3_errmsg(db));
+    std::exit(1);
+  }
+
+  void exec(sqlite3* db, std::string_view sql) {
+    if (sqlite3_exec(db, std::string(sql).c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+      fail(db, sql);
+    }
+  }
+
+  sqlite3_stmt* prepare(sqlite3* db, std::string_view sql) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.data(), static_cast<int>(sql.size()), &stmt, nullptr) != SQLITE_OK) {
+      fail(db, sql);
+    }
+    return stmt;
+  }
+
+  // Steps `stmt` to the end and resets it.
+  void drain(sqlite3* db, sqlite3_stmt* stmt) {
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    }
+    if (rc != SQLITE_DONE) {
+      fail(db, "step");
+    }
+    sqlite3_reset(stmt);
+  }
+
+  void report(std::string_view name, int operations, const std::function<void()>& body) {
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::println("{:<34} {:>10.1f} ms {:>12.2f} us/op", name, elapsed.count(), elapsed.count() * 1000.0 / operations);
+  }
+} // private namespace
+
+int main(int argc, char* argv[]) {
+  const int tasks = argc > 1 ? std::atoi(argv[1]) : DEFAULT_TASKS;
+  if (tasks < COMPLETIONS) {
+    std::println(stderr, "usage: {} [tasks >= {}]", argv[0], COMPLETIONS);
+    return 2;
+  }
+
+  const auto path = std::filesystem::temp_directory_path() / std::format("nudge-sqlite-bench-{}.db", getpid());
+  sqlite3* db = nullptr;
+  if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+    fail(db, "open");
+  }
+
+  std::println("SQLite {} (threadsafe={}), {} tasks", sqlite3_libversion(), sqlite3_threadsafe(), tasks);
+  exec(db, "PRAGMA journal_mode = WAL;");
+  exec(db, "PRAGMA synchronous = NORMAL;");
+  exec(db, Queries::BEGIN_IMMEDIATE_QUERY);
+  for (const auto& migration : Queries::MIGRATIONS) {
+    for (std::string_view query : migration) {
+      exec(db, query);
+    }
+  }
+  exec(db, Queries::COMMIT_QUERY);
+
+  sqlite3_stmt* insert = prepare(db, Queries::INSERT_TASK_QUERY);
+  auto add = [&](int i) {
+    const std::string text = std::format("task {} buy milk and call {}", i, i % 97);
+    sqlite3_bind_text(insert, 1, text.c_str(), -1, SQLITE_TRANSIENT);
+    drain(db, insert);
+  };
+
+  report("add, one transaction each", SINGLE_ADDS, [&] {
+    for (int i = 0; i < SINGLE_ADDS; i++) {
+      add(i);
+    }
+  });
+  report("add, one transaction", tasks - SINGLE_ADDS, [&] {
+    exec(db, Queries::BEGIN_IMMEDIATE_QUERY);
+    for (int i = SINGLE_ADDS; i < tasks; i++) {
+      add(i);
+    }
+    exec(db, Queries::COMMIT_QUERY);
+  });
+
+  sqlite3_stmt* complete = prepare(db, Queries::COMPLETE_TASK_BY_ID_QUERY);
+  report("complete by id", COMPLETIONS, [&] {
+    for (int id = 1; id <= COMPLETIONS; id++) {
+      sqlite3_bind_int64(complete, 1, id * (tasks / COMPLETIONS));
+      drain(db, complete);
+    }
+  });
+
+  sqlite3_stmt* list = prepare(db, Queries::SELECT_ALL_TASKS_QUERY);
+  report("list pending", LIST_REPEATS, [&] {
+    for (int i = 0; i < LIST_REPEATS; i++) {
+      drain(db, list);
+    }
+  });
+
+  sqlite3_stmt* completed = prepare(db, Queries::SELECT_COMPLETED_TASK_QUERY);
+  report("list completed", LIST_REPEATS, [&] {
+    for (int i = 0; i < LIST_REPEATS; i++) {
+      drain(db, completed);
+    }
+  });
+
+  sqlite3_stmt* count = prepare(db, Queries::COUNT_PENDING_TASKS_QUERY);
+  report("count pending", COUNT_REPEATS, [&] {
+    for (int i = 0; i < COUNT_REPEATS; i++) {
+      drain(db, count);
+    }
+  });
+
+  sqlite3_stmt* search = prepare(db, Queries::SEARCH_TASKS_QUERY);
+  report("full-text search", SEARCHES, [&] {
+    for (int i = 0; i < SEARCHES; i++) {
+      const std::string match = std::format("\"call\" \"{}\"", i % 97);
+      sqlite3_bind_text(search, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_text(search, 2, "[", -1, SQLITE_STATIC);
+      sqlite3_bind_text(search, 3, "]", -1, SQLITE_STATIC);
+      sqlite3_bind_int(search, 4, 50);
+      drain(db, search);
+    }
+  });
+
+  for (sqlite3_stmt* stmt : {insert, complete, list, completed, count, search}) {
+    sqlite3_finalize(stmt);
+  }
+  sqlite3_close(db);
+
+  std::error_code ec;
+  for (const char* suffix : {"", "-wal", "-shm"}) {
+    std::filesystem::remove(path.string() + suffix, ec);
+  }
+  return 0;
+}
@@ -0,0 +1,154 @@
+// Runs one TaskStore workload against each backend: SqliteStore (the
+// default), LogStore (backend = log) and MemoryStore as the in-process floor:
+//
+//   cmake -S . -B build -DNUDGE_BUILD_BENCHMARKS=ON
+//   cmake --build build --target nudge_task_store_bench
+//   ./build/nudge_task_store_bench [tasks]
+//
+// Every store call commits on its own, as one CLI command would. "reopen"
+// times opening the store again on the full data set, which every command
+// pays. HOME points at a scratch directory, so the config defaults apply.
+
+#include <print>
+#include <format>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <cstdlib>
+#include <functional>
+#include <filesystem>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "paths.hpp"
+#include "settings.hpp"
+#include "database.hpp"
+#include "task_store.hpp"
+#include "sqlite_store.hpp"
+#include "memory_store.hpp"
+#include "log_store.hpp"
+
+namespace {
+  constexpr int DEFAULT_TASKS = 20000;
+  constexpr int REOPENS = 20;
+  constexpr int LISTS = 20;
+  constexpr int COUNTS = 1000;
+  constexpr int MATCHES = 20;
+
+  void report(std::string_view backend, std::string_view name, int operations, const std::function<void()>& body) {
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::println("{:<8} {:<24} {:>10.1f} ms {:>12.2f} us/op", backend, name, elapsed.count(),
+                 elapsed.count() * 1000.0 / operations);
+  }
+
+  // A store over a fresh data set. `session` keeps alive whatever the store
+  // runs on and is destroyed after it. `persistent` stores can be reopened.
+  struct StoreUnderTest {
+    std::string_view name;
+    bool persistent;
+    std::function<std::unique_ptr<TaskStore>(std::unique_ptr<Database>& session)> open;
+  };
+
+  void run(const StoreUnderTest& backend, int tasks) {
+    std::unique_ptr<Database> session;
+    auto store = backend.open(session);
+
+    report(backend.name, "add", tasks, [&] {
+      for (int i = 0; i < tasks; i++) {
+        store->add(std::format("task {} buy milk and call {}", i, i % 97));
+      }
+    });
+
+    // Every tenth task, spread over the whole range.
+    const int completions = tasks / 10;
+    report(backend.name, "complete by id", completions, [&] {
+      for (int id = 10; id <= tasks; id += 10) {
+        store->completeById(id);
+      }
+    });
+
+    if (backend.persistent) {
+      report(backend.name, "reopen", REOPENS, [&] {
+        for (int i = 0; i < REOPENS; i++) {
+          store.reset();
+          session.reset();
+          store = backend.open(session);
+        }
+      });
+    }
+
+    long long listed = 0;
+    report(backend.name, "list pending", LISTS, [&] {
+      for (int i = 0; i < LISTS; i++) {
+        store->forEachPending([&](const Task&) { listed++; });
+      }
+    });
+
+    long long counted = 0;
+    report(backend.name, "count pending", COUNTS, [&] {
+      for (int i = 0; i < COUNTS; i++) {
+        counted += store->countPending();
+      }
+    });
+
+    // Each pattern matches a single task, but every pending task is scanned.
+    report(backend.name, "complete matching", MATCHES, [&] {
+      for (int i = 0; i < MATCHES; i++) {
+        store->completeMatching(std::format("task {} ", 2 * i + 1), [](const Task&) {});
+      }
+    });
+
+    report(backend.name, "first pending", COUNTS, [&] {
+      for (int i = 0; i < COUNTS; i++) {
+        store->firstPending();
+      }
+    });
+
+    if (listed != static_cast<long long>(LISTS) * counted / COUNTS) {
+      std::println(stderr, "{}: listed {} tasks but counted {}", backend.name, listed / LISTS, counted / COUNTS);
+    }
+  }
+} // private namespace
+
+int main(int argc, char* argv[]) {
+  const int tasks = argc > 1 ? std::atoi(argv[1]) : DEFAULT_TASKS;
+  if (tasks < 10) {
+    std::println(stderr, "usage: {} [tasks >= 10]", argv[0]);
+    return 2;
+  }
+
+  const auto home = std::filesystem::temp_directory_path() / std::format("nudge-task-store-bench-{}", getpid());
+  std::filesystem::create_directories(home / ".nudge");
+  setenv("HOME", home.c_str(), 1);
+
+  const StoreUnderTest backends[] = {
+    {"sqlite", true, [](std::unique_ptr<Database>& session) -> std::unique_ptr<TaskStore> {
+       session = std::make_unique<Database>();
+       database::setupTables(*session);
+       return std::make_unique<SqliteStore>(*session);
+     }},
+    {"log", true, [](std::unique_ptr<Database>&) -> std::unique_ptr<TaskStore> {
+       return std::make_unique<LogStore>();
+     }},
+    {"memory", false, [](std::unique_ptr<Database>&) -> std::unique_ptr<TaskStore> {
+       return std::make_unique<MemoryStore>();
+     }},
+  };
+
+  std::println("{} tasks, synchronous = {}", tasks, settings::name(settings::current().synchronous));
+  int status = 0;
+  try {
+    for (const auto& backend : backends) {
+      run(backend, tasks);
+    }
+  } catch (const std::exception& e) {
+    std::println(stderr, "{}", e.what());
+    status = 1;
+  }
+
+  std::filesystem::remove_all(home);
+  return status;
+}
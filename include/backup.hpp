@@ -0,0 +1,22 @@
+#pragma once
+
+#include "flags.hpp"
+
+class Database;
+
+// Online copies of the main database through SQLite's backup API.
+//
+// `nudge backup [--pages=N] [--keep=K] [dest]` copies N pages per step and
+// sleeps briefly between steps, so adds and completes from other processes
+// keep going while it runs. `dest` may be a file, or a directory (default
+// ~/.nudge/backups/) that gets a timestamped list-YYYYmmdd-HHMMSS.db. Only
+// the newest K of those are kept. Every copy passes PRAGMA quick_check
+// before it replaces anything.
+//
+// `nudge restore <file>` checks the file with quick_check first. It then
+// copies it over the live database in a single step, checks the result
+// again and migrates it to the current schema.
+namespace backup {
+  bool create(Database& db, const ParsedCommand& pc);
+  bool restore(Database& db, const ParsedCommand& pc);
+} // backup
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <string>
 #include <string_view>
+#include <span>
+#include <filesystem>
 #include <memory>
+#include <vector>
+#include <cstddef>
 #include <stdexcept>
+#include <unordered_map>
 
 #include "sqlite3.h"
 #include "flags.hpp"
@@ -29,14 +35,90 @@ struct StmtDeleter {
 using DatabasePtr = std::unique_ptr<sqlite3, SqliteDeleter>;
 using StatementPtr = std::unique_ptr<sqlite3_stmt, StmtDeleter>;
 
+// Stored in tasks.status as a small integer (schema version 5 onwards).
+enum class TaskStatus : int {
+  Pending = 0,
+  Completed = 1,
+};
+
 class DatabaseException : public std::runtime_error {
   public:
     DatabaseException(const std::string& message) : std::runtime_error(message) {}
 };
 
+// How a command intends to use the database. Read-only sessions never take the
+// write lock, so pollers that only list or count do not contend with writers.
+enum class Access {
+  ReadWrite,
+  ReadOnly,
+  Immutable, // read-only, opened with immutable=1: no locking or change detection, for snapshot files
+  NoLock,    // read-only, opened with nolock=1: skips file locking but still notices changes
+};
+
+// Prepared statements keyed by query text. A statement is borrowed through a
+// Lease and goes back to the cache, reset and with its bindings cleared, when
+// the lease ends, so repeated queries on one connection are only parsed once.
+class StatementCache {
+  public:
+    struct Stats {
+      std::size_t hits = 0;
+      std::size_t misses = 0;
+    };
+
+    class Lease {
+      public:
+        Lease(std::vector<StatementPtr>* pool, StatementPtr stmt) : pool(pool), stmt(std::move(stmt)) {}
+        Lease(Lease&& other) noexcept = default;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        sqlite3_stmt* get() const { return stmt.get(); }
+
+      private:
+        std::vector<StatementPtr>* pool;
+        StatementPtr stmt;
+    };
+
+    explicit StatementCache(sqlite3* db) : db(db) {}
+
+    Lease acquire(std::string_view query);
+    const Stats& stats() const { return counters; }
+
+  private:
+    sqlite3* db;
+    std::unordered_map<std::string, std::vector<StatementPtr>> idle;
+    Stats counters;
+};
+
+// One connection for the lifetime of a command; every database:: call runs on it
+// so the cost of opening the file and reading the schema is paid once.
+//
+// With `inMemory` the connection is an in-memory copy of the whole file (see
+// database::openInMemory). A read-write copy keeps the file's write lock until
+// database::writeBack() stores it again.
+class Database {
+  public:
+    explicit Database(Access access = Access::ReadWrite, bool inMemory = false);
+
+    sqlite3* get() const { return handle.get(); }
+    Access access() const { return mode; }
+    // The on-disk connection behind an in-memory read-write session, otherwise null.
+    sqlite3* file() const { return disk.get(); }
+
+    StatementCache::Lease prepare(std::string_view query) { return statements.acquire(query); }
+    const StatementCache::Stats& cacheStats() const { return statements.stats(); }
+
+  private:
+    // Declared after the handle so cached statements are finalized before the connection closes.
+    Access mode;
+    DatabasePtr disk;
+    DatabasePtr handle;
+    StatementCache statements;
+};
+
 namespace Queries {
-  // Use local device time for timestamps by using SQLite's 'localtime' modifier.
-  // SQLite's CURRENT_TIMESTAMP is UTC; using datetime('now','localtime') stores local time.
+  // Version 1 layout. It stored local device time as text through SQLite's
+  // 'localtime' modifier; version 5 replaces that with UTC epoch integers.
   inline constexpr std::string_view TODO_TABLE_QUERY = R"(
         CREATE TABLE IF NOT EXISTS tasks(
         id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -52,24 +134,505 @@ namespace Queries {
         completed_at DATETIME DEFAULT (datetime('now','localtime')));
     )";
 
-  inline constexpr std::string_view INSERT_TASK_QUERY = "INSERT INTO tasks (task, status) VALUES (?, 'pending');";
-  inline constexpr std::string_view DELETE_TASK_QUERY = "DELETE FROM tasks WHERE id = ?;";
+  // Schema migrations: step N upgrades a database whose PRAGMA user_version is N
+  // to N + 1. Append new steps here; never edit one that has already shipped.
+  inline constexpr std::string_view SCHEMA_V1[] = { TODO_TABLE_QUERY, COMPLETED_TABLE_QUERY };
+
+  // Version 2 has no DDL: it exists so databases created before WAL was adopted
+  // pass through setupTables(), which switches every migrated file to WAL.
+  inline constexpr std::span<const std::string_view> SCHEMA_V2 = {};
+
+  // Version 3: indexes for every ordered or filtered read. The rowid tie-break
+  // keeps ordering deterministic between rows stamped in the same second, and
+  // the trailing columns make the listings index-only.
+  inline constexpr std::string_view SCHEMA_V3[] = {
+    "CREATE INDEX IF NOT EXISTS tasks_created_idx ON tasks(created_at, id, status, task);",
+    "CREATE INDEX IF NOT EXISTS tasks_status_idx ON tasks(status);",
+    "CREATE INDEX IF NOT EXISTS completed_at_idx ON completed(completed_at, id, task);",
+  };
+
+  // Version 4: FTS5 external-content indexes over the task text of both tables,
+  // kept in sync by triggers and backfilled with 'rebuild'. The 2- and 3-character
+  // prefix indexes make "milk*"-style queries cheap.
+  inline constexpr std::string_view SCHEMA_V4[] = {
+    "CREATE VIRTUAL TABLE IF NOT EXISTS tasks_fts USING fts5(task, content='tasks', content_rowid='id', prefix='2 3');",
+    R"(CREATE TRIGGER IF NOT EXISTS tasks_fts_insert AFTER INSERT ON tasks BEGIN
+         INSERT INTO tasks_fts(rowid, task) VALUES (new.id, new.task);
+       END;)",
+    R"(CREATE TRIGGER IF NOT EXISTS tasks_fts_delete AFTER DELETE ON tasks BEGIN
+         INSERT INTO tasks_fts(tasks_fts, rowid, task) VALUES ('delete', old.id, old.task);
+       END;)",
+    R"(CREATE TRIGGER IF NOT EXISTS tasks_fts_update AFTER UPDATE OF task ON tasks BEGIN
+         INSERT INTO tasks_fts(tasks_fts, rowid, task) VALUES ('delete', old.id, old.task);
+         INSERT INTO tasks_fts(rowid, task) VALUES (new.id, new.task);
+       END;)",
+    "INSERT INTO tasks_fts(tasks_fts) VALUES ('rebuild');",
+
+    "CREATE VIRTUAL TABLE IF NOT EXISTS completed_fts USING fts5(task, content='completed', content_rowid='id', prefix='2 3');",
+    R"(CREATE TRIGGER IF NOT EXISTS completed_fts_insert AFTER INSERT ON completed BEGIN
+         INSERT INTO completed_fts(rowid, task) VALUES (new.id, new.task);
+       END;)",
+    R"(CREATE TRIGGER IF NOT EXISTS completed_fts_delete AFTER DELETE ON completed BEGIN
+         INSERT INTO completed_fts(completed_fts, rowid, task) VALUES ('delete', old.id, old.task);
+       END;)",
+    R"(CREATE TRIGGER IF NOT EXISTS completed_fts_update AFTER UPDATE OF task ON completed BEGIN
+         INSERT INTO completed_fts(completed_fts, rowid, task) VALUES ('delete', old.id, old.task);
+         INSERT INTO completed_fts(rowid, task) VALUES (new.id, new.task);
+       END;)",
+    "INSERT INTO completed_fts(completed_fts) VALUES ('rebuild');",
+  };
+
+  // Shared by SCHEMA_V5 and the importer, which drops and recreates it per batch.
+  inline constexpr std::string_view CREATE_FTS_INSERT_TRIGGER_QUERY = R"(CREATE TRIGGER tasks_fts_insert AFTER INSERT ON tasks BEGIN
+         INSERT INTO tasks_fts(rowid, task) VALUES (new.id, new.task);
+       END;)";
+
+  // Version 5: compact rows. STRICT tables store status as a TaskStatus integer
+  // and timestamps as UTC Unix epoch seconds; local time is applied only when
+  // rendering. Each table is rebuilt in place: the old one is renamed aside, its
+  // rows copied across with ids and the AUTOINCREMENT high-water mark kept, and
+  // the indexes and FTS triggers that were dropped with it recreated.
+  // strftime('%s', t, 'utc') reads the stored local time and converts it to UTC.
+  inline constexpr std::string_view SCHEMA_V5[] = {
+    "ALTER TABLE tasks RENAME TO tasks_v4;",
+    R"(CREATE TABLE tasks (
+         id INTEGER PRIMARY KEY AUTOINCREMENT,
+         task TEXT NOT NULL,
+         status INTEGER NOT NULL DEFAULT 0,
+         created_at INTEGER NOT NULL DEFAULT (unixepoch())
+       ) STRICT;)",
+    R"(INSERT INTO tasks (id, task, status, created_at)
+         SELECT id, task, 0, COALESCE(CAST(strftime('%s', created_at, 'utc') AS INTEGER), unixepoch())
+         FROM tasks_v4;)",
+    "DELETE FROM sqlite_sequence WHERE name = 'tasks';",
+    "INSERT INTO sqlite_sequence (name, seq) SELECT 'tasks', seq FROM sqlite_sequence WHERE name = 'tasks_v4';",
+    "DROP TABLE tasks_v4;",
+
+    "ALTER TABLE completed RENAME TO completed_v4;",
+    R"(CREATE TABLE completed (
+         id INTEGER PRIMARY KEY AUTOINCREMENT,
+         task TEXT NOT NULL,
+         completed_at INTEGER NOT NULL DEFAULT (unixepoch())
+       ) STRICT;)",
+    R"(INSERT INTO completed (id, task, completed_at)
+         SELECT id, task, COALESCE(CAST(strftime('%s', completed_at, 'utc') AS INTEGER), unixepoch())
+         FROM completed_v4;)",
+    "DELETE FROM sqlite_sequence WHERE name = 'completed';",
+    "INSERT INTO sqlite_sequence (name, seq) SELECT 'completed', seq FROM sqlite_sequence WHERE name = 'completed_v4';",
+    "DROP TABLE completed_v4;",
+
+    "CREATE INDEX tasks_created_idx ON tasks(created_at, id, status, task);",
+    "CREATE INDEX tasks_status_idx ON tasks(status);",
+    "CREATE INDEX completed_at_idx ON completed(completed_at, id, task);",
+    CREATE_FTS_INSERT_TRIGGER_QUERY,
+    R"(CREATE TRIGGER tasks_fts_delete AFTER DELETE ON tasks BEGIN
+         INSERT INTO tasks_fts(tasks_fts, rowid, task) VALUES ('delete', old.id, old.task);
+       END;)",
+    R"(CREATE TRIGGER tasks_fts_update AFTER UPDATE OF task ON tasks BEGIN
+         INSERT INTO tasks_fts(tasks_fts, rowid, task) VALUES ('delete', old.id, old.task);
+         INSERT INTO tasks_fts(rowid, task) VALUES (new.id, new.task);
+       END;)",
+    R"(CREATE TRIGGER completed_fts_insert AFTER INSERT ON completed BEGIN
+         INSERT INTO completed_fts(rowid, task) VALUES (new.id, new.task);
+       END;)",
+    R"(CREATE TRIGGER completed_fts_delete AFTER DELETE ON completed BEGIN
+         INSERT INTO completed_fts(completed_fts, rowid, task) VALUES ('delete', old.id, old.task);
+       END;)",
+    R"(CREATE TRIGGER completed_fts_update AFTER UPDATE OF task ON completed BEGIN
+         INSERT INTO completed_fts(completed_fts, rowid, task) VALUES ('delete', old.id, old.task);
+         INSERT INTO completed_fts(rowid, task) VALUES (new.id, new.task);
+       END;)",
+  };
+
+  // Version 6: one table for the whole task lifecycle. Completing a task flips
+  // status and stamps completed_at in place, keeping its id and created_at.
+  // Completed rows move over with fresh ids (their creation time was never
+  // recorded, so it is taken from completed_at) and are indexed into tasks_fts by
+  // its insert trigger. Partial indexes serve the pending and completed views; the
+  // queries must repeat their `status = N` literally for the planner to use them.
+  inline constexpr std::string_view SCHEMA_V6[] = {
+    "ALTER TABLE tasks ADD COLUMN completed_at INTEGER;",
+    R"(INSERT INTO tasks (task, status, created_at, completed_at)
+         SELECT task, 1, completed_at, completed_at FROM completed ORDER BY id;)",
+    "DROP TABLE completed;",
+    "DROP TABLE completed_fts;",
+    "DROP INDEX tasks_created_idx;",
+    "DROP INDEX tasks_status_idx;",
+    "CREATE INDEX tasks_pending_idx ON tasks(created_at, id, task) WHERE status = 0;",
+    "CREATE INDEX tasks_completed_idx ON tasks(completed_at, id, task) WHERE status = 1;",
+  };
+
+  // Version 7: small key/value bookkeeping, starting with the write count that
+  // triggers opportunistic maintenance.
+  inline constexpr std::string_view SCHEMA_V7[] = {
+    "CREATE TABLE meta (key TEXT PRIMARY KEY, value INTEGER NOT NULL) STRICT, WITHOUT ROWID;",
+    "INSERT INTO meta (key, value) VALUES ('writes_since_maintenance', 0);",
+  };
+
+  // Version 8: counters kept exact by triggers, so notify reads one row instead
+  // of counting. completed_today counts completions since local midnight of
+  // the day in completed_day; once that day is over it reads as 0 and the first
+  // completion of a new day starts it again. The old completed table was merged
+  // into tasks in version 6, so tasks is the only table that needs triggers.
+  // Also recreated by bulk import, which drops it per batch and adds the
+  // batch's rows to the counters in one go (UPDATE_COUNTERS_AFTER_ID_QUERIES).
+  inline constexpr std::string_view CREATE_COUNTERS_INSERT_TRIGGER_QUERY = R"(CREATE TRIGGER counters_insert AFTER INSERT ON tasks BEGIN
+         UPDATE counters SET value = value + 1 WHERE name = 'total';
+         UPDATE counters SET value = value + 1 WHERE name = 'pending' AND new.status = 0;
+         UPDATE counters SET value = CASE
+             WHEN (SELECT value FROM counters WHERE name = 'completed_day') = unixepoch('now', 'localtime', 'start of day', 'utc')
+             THEN value + 1 ELSE 1 END
+           WHERE name = 'completed_today' AND new.status = 1
+             AND new.completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc');
+         UPDATE counters SET value = unixepoch('now', 'localtime', 'start of day', 'utc')
+           WHERE name = 'completed_day' AND new.status = 1
+             AND new.completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc');
+       END;)";
+
+  inline constexpr std::string_view SCHEMA_V8[] = {
+    "CREATE TABLE counters (name TEXT PRIMARY KEY, value INTEGER NOT NULL) STRICT, WITHOUT ROWID;",
+    R"(INSERT INTO counters (name, value) VALUES
+         ('pending', (SELECT count(*) FROM tasks WHERE status = 0)),
+         ('total', (SELECT count(*) FROM tasks)),
+         ('completed_day', unixepoch('now', 'localtime', 'start of day', 'utc')),
+         ('completed_today', (SELECT count(*) FROM tasks WHERE status = 1
+                               AND completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc')));)",
+    CREATE_COUNTERS_INSERT_TRIGGER_QUERY,
+    R"(CREATE TRIGGER counters_delete AFTER DELETE ON tasks BEGIN
+         UPDATE counters SET value = value - 1 WHERE name = 'total';
+         UPDATE counters SET value = value - 1 WHERE name = 'pending' AND old.status = 0;
+         UPDATE counters SET value = value - 1
+           WHERE name = 'completed_today' AND old.status = 1
+             AND old.completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc')
+             AND (SELECT value FROM counters WHERE name = 'completed_day') = unixepoch('now', 'localtime', 'start of day', 'utc');
+       END;)",
+    R"(CREATE TRIGGER counters_update AFTER UPDATE OF status ON tasks WHEN old.status <> new.status BEGIN
+         UPDATE counters SET value = value + (new.status = 0) - (old.status = 0) WHERE name = 'pending';
+         UPDATE counters SET value = value - 1
+           WHERE name = 'completed_today' AND old.status = 1
+             AND old.completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc')
+             AND (SELECT value FROM counters WHERE name = 'completed_day') = unixepoch('now', 'localtime', 'start of day', 'utc');
+         UPDATE counters SET value = CASE
+             WHEN (SELECT value FROM counters WHERE name = 'completed_day') = unixepoch('now', 'localtime', 'start of day', 'utc')
+             THEN value + 1 ELSE 1 END
+           WHERE name = 'completed_today' AND new.status = 1
+             AND new.completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc');
+         UPDATE counters SET value = unixepoch('now', 'localtime', 'start of day', 'utc')
+           WHERE name = 'completed_day' AND new.status = 1
+             AND new.completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc');
+       END;)",
+  };
+
+  // Version 9: a partial index behind every `list --sort` order of each view, so
+  // a page is a range read of at most --limit entries. Pending by creation time
+  // and completed by completion time are already tasks_pending_idx and
+  // tasks_completed_idx. Text sorts ignore case, so those queries must say
+  // `task COLLATE NOCASE` to match.
+  inline constexpr std::string_view SCHEMA_V9[] = {
+    "CREATE INDEX tasks_pending_id_idx ON tasks(id) WHERE status = 0;",
+    "CREATE INDEX tasks_pending_text_idx ON tasks(task COLLATE NOCASE, id) WHERE status = 0;",
+    "CREATE INDEX tasks_completed_created_idx ON tasks(created_at, id) WHERE status = 1;",
+    "CREATE INDEX tasks_completed_id_idx ON tasks(id) WHERE status = 1;",
+    "CREATE INDEX tasks_completed_text_idx ON tasks(task COLLATE NOCASE, id) WHERE status = 1;",
+  };
+
+  // Version 10: the write count behind opportunistic maintenance is kept by
+  // triggers, so it is bumped inside each command's own transaction rather than
+  // by a second write after it. One task row inserted, deleted or updated is one
+  // write. Bulk import drops writes_insert per batch like the other insert
+  // triggers and adds the batch's row count itself.
+  inline constexpr std::string_view CREATE_WRITES_INSERT_TRIGGER_QUERY = R"(CREATE TRIGGER writes_insert AFTER INSERT ON tasks BEGIN
+         UPDATE meta SET value = value + 1 WHERE key = 'writes_since_maintenance';
+       END;)";
+
+  inline constexpr std::string_view SCHEMA_V10[] = {
+    CREATE_WRITES_INSERT_TRIGGER_QUERY,
+    R"(CREATE TRIGGER writes_delete AFTER DELETE ON tasks BEGIN
+         UPDATE meta SET value = value + 1 WHERE key = 'writes_since_maintenance';
+       END;)",
+    R"(CREATE TRIGGER writes_update AFTER UPDATE ON tasks BEGIN
+         UPDATE meta SET value = value + 1 WHERE key = 'writes_since_maintenance';
+       END;)",
+  };
+
+  inline constexpr std::span<const std::string_view> MIGRATIONS[] = {
+    SCHEMA_V1, SCHEMA_V2, SCHEMA_V3, SCHEMA_V4, SCHEMA_V5, SCHEMA_V6, SCHEMA_V7, SCHEMA_V8, SCHEMA_V9, SCHEMA_V10,
+  };
+  inline constexpr int SCHEMA_VERSION = static_cast<int>(std::size(MIGRATIONS));
+
+  inline constexpr std::string_view SCHEMA_VERSION_QUERY = "PRAGMA user_version;";
+  // journal_mode cannot change inside a transaction, so this runs after the migration commits.
+  inline constexpr std::string_view JOURNAL_MODE_WAL_QUERY = "PRAGMA journal_mode = WAL;";
+
+  // Status literals below mirror TaskStatus; they stay literal so the partial indexes apply.
+  inline constexpr std::string_view INSERT_TASK_QUERY = "INSERT INTO tasks (task) VALUES (?);";
+  // Bulk import keeps the source's timestamps; ?3/?4 may be NULL. A completed
+  // task without a completion time is stamped with its creation time, or now.
+  inline constexpr std::string_view IMPORT_TASK_QUERY = R"(
+        INSERT INTO tasks (task, status, created_at, completed_at)
+        VALUES (?1, ?2, coalesce(?3, unixepoch()), CASE WHEN ?2 = 1 THEN coalesce(?4, ?3, unixepoch()) END);
+    )";
+  // Per-row FTS trigger work dominates a bulk import, so each import batch drops
+  // tasks_fts_insert, indexes the batch's new rows with one INSERT ... SELECT and
+  // recreates it from CREATE_FTS_INSERT_TRIGGER_QUERY before committing. The
+  // counters_insert trigger gets the same treatment.
+  inline constexpr std::string_view DROP_FTS_INSERT_TRIGGER_QUERY = "DROP TRIGGER tasks_fts_insert;";
+  inline constexpr std::string_view DROP_COUNTERS_INSERT_TRIGGER_QUERY = "DROP TRIGGER counters_insert;";
+  inline constexpr std::string_view UPDATE_COUNTERS_AFTER_ID_QUERIES[] = {
+    R"(UPDATE counters SET value = value + CASE name
+           WHEN 'total' THEN (SELECT count(*) FROM tasks WHERE id > ?1)
+           ELSE (SELECT count(*) FROM tasks WHERE id > ?1 AND status = 0) END
+         WHERE name IN ('total', 'pending');)",
+    R"(UPDATE counters SET value = (CASE
+             WHEN (SELECT value FROM counters WHERE name = 'completed_day') = unixepoch('now', 'localtime', 'start of day', 'utc')
+             THEN value ELSE 0 END)
+           + (SELECT count(*) FROM tasks WHERE id > ?1 AND status = 1
+                AND completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc'))
+         WHERE name = 'completed_today';)",
+    R"(UPDATE counters SET value = unixepoch('now', 'localtime', 'start of day', 'utc')
+         WHERE name = 'completed_day' AND EXISTS (SELECT 1 FROM tasks WHERE id > ?1 AND status = 1
+           AND completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc'));)",
+  };
+  inline constexpr std::string_view MAX_TASK_ID_QUERY = "SELECT coalesce(max(id), 0) FROM tasks;";
+  inline constexpr std::string_view INDEX_TASKS_AFTER_ID_QUERY = "INSERT INTO tasks_fts(rowid, task) SELECT id, task FROM tasks WHERE id > ?;";
+  inline constexpr std::string_view DELETE_TASK_QUERY = "DELETE FROM tasks WHERE id = ? AND status = 0;";
+
+  inline constexpr std::string_view SELECT_FIRST_PENDING_TASK_QUERY = "SELECT id, task, created_at FROM tasks WHERE status = 0 ORDER BY created_at ASC, id ASC LIMIT 1;";
+  inline constexpr std::string_view COUNT_PENDING_TASKS_QUERY = "SELECT value FROM counters WHERE name = 'pending';";
+  inline constexpr std::string_view SELECT_ALL_TASKS_QUERY = "SELECT id, task, created_at FROM tasks WHERE status = 0 ORDER BY created_at DESC, id DESC;";
+  inline constexpr std::string_view SELECT_COMPLETED_TASK_QUERY = "SELECT task, completed_at FROM tasks WHERE status = 1 ORDER BY completed_at DESC, id DESC;";
+
+  // One page of `list --sort ...`, starting after the row whose sort key and id
+  // are ?1 and ?2, at most ?3 rows. Times and ids run newest first, text A-Z
+  // ignoring case. The first page binds a key that sorts before every row.
+  // Pending pages return id, task, created_at; completed pages task,
+  // completed_at, id (as SELECT_COMPLETED_TASK_QUERY, plus the id). The sort key
+  // is the last column either way. The text pages repeat the first key column on
+  // its own so the planner seeks to it instead of scanning from the start.
+  inline constexpr std::string_view PAGE_PENDING_BY_CREATED_QUERY =
+      "SELECT id, task, created_at, created_at FROM tasks WHERE status = 0 AND (created_at, id) < (?1, ?2) ORDER BY created_at DESC, id DESC LIMIT ?3;";
+  inline constexpr std::string_view PAGE_PENDING_BY_ID_QUERY =
+      "SELECT id, task, created_at, id FROM tasks WHERE status = 0 AND id < ?2 ORDER BY id DESC LIMIT ?3;";
+  inline constexpr std::string_view PAGE_PENDING_BY_TEXT_QUERY =
+      "SELECT id, task, created_at, task FROM tasks WHERE status = 0 AND task COLLATE NOCASE >= ?1 AND (task COLLATE NOCASE, id) > (?1, ?2) ORDER BY task COLLATE NOCASE, id LIMIT ?3;";
+  inline constexpr std::string_view PAGE_COMPLETED_BY_COMPLETED_QUERY =
+      "SELECT task, completed_at, id, completed_at FROM tasks WHERE status = 1 AND (completed_at, id) < (?1, ?2) ORDER BY completed_at DESC, id DESC LIMIT ?3;";
+  inline constexpr std::string_view PAGE_COMPLETED_BY_CREATED_QUERY =
+      "SELECT task, completed_at, id, created_at FROM tasks WHERE status = 1 AND (created_at, id) < (?1, ?2) ORDER BY created_at DESC, id DESC LIMIT ?3;";
+  inline constexpr std::string_view PAGE_COMPLETED_BY_ID_QUERY =
+      "SELECT task, completed_at, id, id FROM tasks WHERE status = 1 AND id < ?2 ORDER BY id DESC LIMIT ?3;";
+  inline constexpr std::string_view PAGE_COMPLETED_BY_TEXT_QUERY =
+      "SELECT task, completed_at, id, task FROM tasks WHERE status = 1 AND task COLLATE NOCASE >= ?1 AND (task COLLATE NOCASE, id) > (?1, ?2) ORDER BY task COLLATE NOCASE, id LIMIT ?3;";
+  // Completion is set-based: each selector is one UPDATE whose RETURNING rows are what got completed.
+  inline constexpr std::string_view COMPLETE_TASK_BY_ID_QUERY = "UPDATE tasks SET status = 1, completed_at = unixepoch() WHERE id = ? AND status = 0 RETURNING id, task, created_at, completed_at;";
+  // ? is a JSON array of ids, e.g. '[3,7,12]'.
+  inline constexpr std::string_view COMPLETE_TASKS_BY_IDS_QUERY = "UPDATE tasks SET status = 1, completed_at = unixepoch() WHERE status = 0 AND id IN (SELECT value FROM json_each(?)) RETURNING id, task, created_at, completed_at;";
+  inline constexpr std::string_view COMPLETE_TASKS_MATCHING_QUERY = "UPDATE tasks SET status = 1, completed_at = unixepoch() WHERE status = 0 AND nudge_contains(task, ?) RETURNING id, task, created_at, completed_at;";
+  // ? is an age in seconds.
+  inline constexpr std::string_view COMPLETE_TASKS_OLDER_THAN_QUERY = "UPDATE tasks SET status = 1, completed_at = unixepoch() WHERE status = 0 AND created_at < unixepoch() - ? RETURNING id, task, created_at, completed_at;";
+  // ?1 is an FTS5 match expression, ?2/?3 wrap highlighted terms, ?4 caps the result count.
+  // Lower bm25() is a better match, so ascending order puts the best hits first.
+  inline constexpr std::string_view SEARCH_TASKS_QUERY = R"(
+        SELECT t.status, t.id, snippet(tasks_fts, 0, ?2, ?3, '...', 16)
+        FROM tasks_fts JOIN tasks t ON t.id = tasks_fts.rowid
+        WHERE tasks_fts MATCH ?1
+        ORDER BY bm25(tasks_fts) LIMIT ?4;
+    )";
+
+  // Completed tasks in a date range (epoch seconds, inclusive) from the hot database.
+  inline constexpr std::string_view SELECT_COMPLETED_RANGE_QUERY = "SELECT task, completed_at FROM tasks WHERE status = 1 AND completed_at BETWEEN ?1 AND ?2 ORDER BY completed_at DESC, id DESC;";
+
+  // Archive partitions: ~/.nudge/archive/YYYY.db, attached as `archive` only while in use.
+  // Rows keep the id they had in the main database, which is unique across all partitions.
+  inline constexpr std::string_view ATTACH_ARCHIVE_QUERY = "ATTACH DATABASE ? AS archive;";
+  inline constexpr std::string_view DETACH_ARCHIVE_QUERY = "DETACH DATABASE archive;";
+  inline constexpr std::string_view ARCHIVE_SCHEMA[] = {
+    R"(CREATE TABLE IF NOT EXISTS archive.completed (
+         id INTEGER PRIMARY KEY,
+         task TEXT NOT NULL,
+         created_at INTEGER NOT NULL,
+         completed_at INTEGER NOT NULL
+       ) STRICT;)",
+    "CREATE INDEX IF NOT EXISTS archive.completed_at_idx ON completed(completed_at, id, task);",
+  };
+  // Years (UTC) that hold completed tasks finished before ?.
+  inline constexpr std::string_view SELECT_ARCHIVABLE_YEARS_QUERY = "SELECT DISTINCT CAST(strftime('%Y', completed_at, 'unixepoch') AS INTEGER) FROM tasks WHERE status = 1 AND completed_at < ?;";
+  // ?1/?2 bound completed_at to [start, end) within one partition's year.
+  inline constexpr std::string_view COPY_TO_ARCHIVE_QUERY = R"(
+        INSERT OR REPLACE INTO archive.completed (id, task, created_at, completed_at)
+        SELECT id, task, created_at, completed_at FROM main.tasks
+        WHERE status = 1 AND completed_at >= ?1 AND completed_at < ?2;
+    )";
+  inline constexpr std::string_view DELETE_ARCHIVED_QUERY = R"(
+        DELETE FROM main.tasks
+        WHERE status = 1 AND completed_at >= ?1 AND completed_at < ?2
+          AND EXISTS (SELECT 1 FROM archive.completed a WHERE a.id = tasks.id);
+    )";
+  // Completed tasks in a date range from the hot database and the attached
+  // partition together, newest first. Import and restore can leave tasks in the
+  // main database that finished in an archived year, so the two overlap; each
+  // side walks its completed_at index and SQLite merges them without a sort.
+  inline constexpr std::string_view SELECT_MERGED_RANGE_QUERY = R"(
+        SELECT task, completed_at, id FROM main.tasks WHERE status = 1 AND completed_at BETWEEN ?1 AND ?2
+        UNION ALL
+        SELECT task, completed_at, id FROM archive.completed WHERE completed_at BETWEEN ?1 AND ?2
+        ORDER BY completed_at DESC, id DESC;
+    )";
+
+  inline constexpr std::string_view SELECT_WRITES_QUERY = "SELECT value FROM meta WHERE key = 'writes_since_maintenance';";
+  inline constexpr std::string_view ADD_WRITES_QUERY = "UPDATE meta SET value = value + ? WHERE key = 'writes_since_maintenance';";
+  inline constexpr std::string_view DROP_WRITES_INSERT_TRIGGER_QUERY = "DROP TRIGGER writes_insert;";
+  inline constexpr std::string_view RESET_WRITES_QUERY = "UPDATE meta SET value = 0 WHERE key = 'writes_since_maintenance';";
+
+  // Export walks the tables in rowid order, so rows stream without a sort.
+  inline constexpr std::string_view EXPORT_TASKS_QUERY = "SELECT id, task, status, created_at, completed_at FROM tasks ORDER BY id;";
+  inline constexpr std::string_view EXPORT_TASKS_BY_STATUS_QUERY = "SELECT id, task, status, created_at, completed_at FROM tasks WHERE status = ? ORDER BY id;";
+  inline constexpr std::string_view EXPORT_ARCHIVED_QUERY = "SELECT id, task, 1, created_at, completed_at FROM archive.completed ORDER BY id;";
+
+  // verify-counters: what the triggers maintain, and the same figures counted from tasks.
+  inline constexpr std::string_view SELECT_COUNTERS_QUERY = R"(
+        SELECT (SELECT value FROM counters WHERE name = 'pending'),
+               (SELECT value FROM counters WHERE name = 'total'),
+               (SELECT CASE WHEN d.value = unixepoch('now', 'localtime', 'start of day', 'utc') THEN t.value ELSE 0 END
+                  FROM counters t, counters d WHERE t.name = 'completed_today' AND d.name = 'completed_day');
+    )";
+  inline constexpr std::string_view COUNT_TASKS_QUERY = R"(
+        SELECT (SELECT count(*) FROM tasks WHERE status = 0),
+               (SELECT count(*) FROM tasks),
+               (SELECT count(*) FROM tasks WHERE status = 1
+                  AND completed_at >= unixepoch('now', 'localtime', 'start of day', 'utc'));
+    )";
+  inline constexpr std::string_view SET_COUNTER_QUERY = "UPDATE counters SET value = ?2 WHERE name = ?1;";
+  inline constexpr std::string_view RESET_COMPLETED_DAY_QUERY =
+      "UPDATE counters SET value = unixepoch('now', 'localtime', 'start of day', 'utc') WHERE name = 'completed_day';";
+
+  // Federated reads (`nudge all`). `{0}` is the schema name a store is attached
+  // under (main for the local database); each query is the store's own indexed
+  // order, merged across stores by federation::run.
+  inline constexpr std::string_view ATTACH_STORE_QUERY = "ATTACH DATABASE ?1 AS {0};";
+  inline constexpr std::string_view DETACH_STORE_QUERY = "DETACH DATABASE {0};";
+  inline constexpr std::string_view STORE_SCHEMA_VERSION_QUERY = "PRAGMA {0}.user_version;";
+  inline constexpr std::string_view STORE_PENDING_QUERY =
+      "SELECT id, task, created_at FROM {0}.tasks WHERE status = 0 ORDER BY created_at DESC, id DESC LIMIT ?1;";
+  inline constexpr std::string_view STORE_COMPLETED_QUERY =
+      "SELECT id, task, completed_at FROM {0}.tasks WHERE status = 1 ORDER BY completed_at DESC, id DESC LIMIT ?1;";
+  inline constexpr std::string_view STORE_SEARCH_QUERY = R"(
+        SELECT t.status, t.id, snippet(tasks_fts, 0, ?2, ?3, '...', 16), bm25(tasks_fts)
+        FROM {0}.tasks_fts JOIN {0}.tasks t ON t.id = tasks_fts.rowid
+        WHERE tasks_fts MATCH ?1
+        ORDER BY bm25(tasks_fts) LIMIT ?4;
+    )";
+  // Pending and total: from the counters from version 8 on, counted before that.
+  inline constexpr std::string_view STORE_COUNTERS_QUERY =
+      "SELECT (SELECT value FROM {0}.counters WHERE name = 'pending'), (SELECT value FROM {0}.counters WHERE name = 'total');";
+  inline constexpr std::string_view STORE_COUNT_TASKS_QUERY =
+      "SELECT (SELECT count(*) FROM {0}.tasks WHERE status = 0), (SELECT count(*) FROM {0}.tasks);";
 
-  inline constexpr std::string_view SELECT_ALL_TASKS_QUERY = "SELECT id, task, status, created_at FROM tasks ORDER BY created_at DESC;";
-  inline constexpr std::string_view SELECT_COMPLETED_TASK_QUERY = "SELECT task, completed_at FROM completed ORDER BY completed_at DESC;";
-  inline constexpr std::string_view SELECT_TASK_BY_ID_QUERY = "SELECT task FROM tasks WHERE id = ?;";
-  inline constexpr std::string_view INSERT_COMPLETED_TASK_QUERY = "INSERT INTO completed (task) VALUES (?);";
   inline constexpr std::string_view BEGIN_TRANSACTION_QUERY = "BEGIN TRANSACTION;";
+  inline constexpr std::string_view BEGIN_IMMEDIATE_QUERY = "BEGIN IMMEDIATE;";
+  inline constexpr std::string_view COMMIT_QUERY = "COMMIT;";
+  inline constexpr std::string_view ROLLBACK_QUERY = "ROLLBACK;";
+
+  // Queries that must be answered from an index: `nudge check-plans` fails if
+  // EXPLAIN QUERY PLAN shows a full table scan or a temporary B-tree for any of them.
+  // The substring and id-list completions are deliberately absent: one cannot use an
+  // index and the other drives its lookups from a json_each() scan.
+  inline constexpr std::string_view INDEXED_QUERIES[] = {
+    SELECT_ALL_TASKS_QUERY,
+    SELECT_COMPLETED_TASK_QUERY,
+    SELECT_COMPLETED_RANGE_QUERY,
+    PAGE_PENDING_BY_CREATED_QUERY,
+    PAGE_PENDING_BY_ID_QUERY,
+    PAGE_PENDING_BY_TEXT_QUERY,
+    PAGE_COMPLETED_BY_COMPLETED_QUERY,
+    PAGE_COMPLETED_BY_CREATED_QUERY,
+    PAGE_COMPLETED_BY_ID_QUERY,
+    PAGE_COMPLETED_BY_TEXT_QUERY,
+    SELECT_FIRST_PENDING_TASK_QUERY,
+    COUNT_PENDING_TASKS_QUERY,
+    COMPLETE_TASK_BY_ID_QUERY,
+    COMPLETE_TASKS_OLDER_THAN_QUERY,
+    DELETE_TASK_QUERY,
+  };
 } // Queries
 
+// Rolls back on scope exit unless commit() succeeded, so a throw halfway
+// through never leaves the shared connection inside an open transaction.
+// Throws DatabaseException when BEGIN or COMMIT fails.
+class Transaction {
+  public:
+    explicit Transaction(Database& db, std::string_view begin = Queries::BEGIN_TRANSACTION_QUERY);
+    ~Transaction();
+
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+
+    void commit();
+
+  private:
+    Database& db;
+    bool committed = false;
+};
+
+// Attaches one archive partition as `archive` for the lifetime of the object.
+// Statements that read it must be finished before this goes out of scope.
+class AttachedArchive {
+  public:
+    AttachedArchive(Database& db, const std::filesystem::path& file);
+    ~AttachedArchive();
+
+    AttachedArchive(const AttachedArchive&) = delete;
+    AttachedArchive& operator=(const AttachedArchive&) = delete;
+
+  private:
+    Database& db;
+};
+
 namespace database {
-  DatabasePtr openDatabase(); 
-  void setupTables(); 
-  bool addTask(const ParsedCommand& pc);
-  bool deleteTask(const ParsedCommand& pc);
-  bool listAllTasks();
-  bool listAllBoth();
-  bool markTaskComplete(const ParsedCommand& pc);
-  bool listAllCompletedCommands(const ParsedCommand& pc);
-  int countPendingTasks();
+  DatabasePtr openDatabase(Access access = Access::ReadWrite); 
+  // Reads Paths::dbPath() into memory with one sequential read (or through
+  // sqlite3_serialize when the WAL still holds commits) and returns an
+  // in-memory connection on that image. For read-write access `disk` is left
+  // open holding the write lock, so no other writer can change the file
+  // before writeBack().
+  DatabasePtr openInMemory(Access access, DatabasePtr& disk);
+  // Stores an in-memory read-write session back into the file, if it changed,
+  // and releases the write lock. Fails without writing if another connection
+  // committed while the lock was handed to the backup. A no-op for ordinary
+  // sessions.
+  bool writeBack(Database& db);
+  int schemaVersion(Database& db);
+  // The value of a command-line `option` as a whole positive number. Throws
+  // DatabaseException naming the option otherwise.
+  long long positiveNumber(const std::string& option, const std::string& value);
+  // Runs `sql` with sqlite3_exec. Throws DatabaseException with SQLite's message.
+  void execOrThrow(Database& db, std::string_view sql);
+  // Turns free text into an FTS5 expression, e.g. `buy mil*` -> `"buy" "mil"*`.
+  std::string ftsQuery(std::string_view text);
+  // Stored UTC epoch seconds as local "YYYY-mm-dd HH:MM:SS", for display.
+  std::string formatLocalTime(sqlite3_int64 epoch);
+  // Archive partitions on disk (Paths::archivePath), newest year first.
+  std::vector<int> archivedYears();
+  void setupTables(Database& db); 
+  bool addTask(Database& db, const ParsedCommand& pc);
+  bool deleteTask(Database& db, const ParsedCommand& pc);
+  bool listAllTasks(Database& db, const ParsedCommand& pc);
+  bool listAllBoth(Database& db);
+  bool markTaskComplete(Database& db, const ParsedCommand& pc);
+  bool listAllCompletedCommands(Database& db, const ParsedCommand& pc);
+  int countPendingTasks(Database& db);
+  bool showSettings(Database& db);
+  bool checkQueryPlans(Database& db);
+  bool searchTasks(Database& db, const ParsedCommand& pc);
+  // Recounts pending, total and completed-today from tasks and repairs any
+  // counter the triggers have drifted from.
+  bool verifyCounters(Database& db);
+  bool archiveCompleted(Database& db, const ParsedCommand& pc);
+  bool maintain(Database& db, const ParsedCommand& pc);
+  // Rows changed on this connection so far; executeCommand() diffs it around each command.
+  long long totalWrites(Database& db);
+  // Once the trigger-maintained write count passes a threshold, spends a short,
+  // bounded slice on incremental vacuum and PRAGMA optimize. Only reads the
+  // count otherwise; executeCommand() calls it after commands that wrote.
+  void maintainIfDue(Database& db);
 } // Database
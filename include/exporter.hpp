@@ -0,0 +1,17 @@
+#pragma once
+
+#include "flags.hpp"
+
+class Database;
+
+// `nudge export [--format=csv|jsonl] [--pending|--completed|--all]`
+//
+// Streams tasks to stdout as CSV (with a header row) or JSON Lines, with the
+// columns id, task, status, created_at and completed_at (UTC epoch seconds).
+// Completed and --all exports include the archive partitions. Rows go from
+// SQLite's column buffers straight into one large output buffer that is
+// written out in big blocks, so memory stays flat however long the history is.
+// The output reads back in with `nudge import`.
+namespace exporter {
+  bool exportTasks(Database& db, const ParsedCommand& pc);
+} // exporter
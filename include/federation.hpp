@@ -0,0 +1,24 @@
+#pragma once
+
+#include "flags.hpp"
+
+class Database;
+
+// Several task databases read as one, e.g. one list.db per machine or team.
+//
+// `nudge store add <name> <path>` records a database under a name in
+// ~/.nudge/stores (one `name = path` line each), `nudge store remove <name>`
+// forgets it and `nudge store list` shows the registry. The local list.db is
+// always there as `local`.
+//
+// `nudge all list [-c] [--limit N]`, `nudge all count` and `nudge all search
+// <query>` ATTACH every registered store read-only next to the local database
+// and run the command across all of them. Each store runs its own indexed
+// ORDER BY; the streams are combined with a k-way merge over a priority queue
+// holding one row per store, so the union is never sorted and a --limit stops
+// reading after N rows. Search results are merged by their per-store bm25
+// rank. Stores must have schema version 6 or newer.
+namespace federation {
+  bool manageStores(Database& db, const ParsedCommand& pc);
+  bool run(Database& db, const ParsedCommand& pc);
+} // federation
@@ -6,6 +6,8 @@
 #include <algorithm>
 #include <print>
 
+class Database;
+
 enum class Flag {
   ADD,
   DEL,
@@ -15,6 +17,19 @@ enum class Flag {
   MARK_COMPLETE,
   SHOW_COMPLETE_TASKS,
   NOTIFY,        // notification users
+  DAEMON,        // run the resident nudged server
+  SHOW_CONFIG,   // print the effective SQLite settings
+  CHECK_PLANS,   // verify indexed queries never scan or sort
+  SEARCH,        // full-text search over pending and completed tasks
+  ARCHIVE,       // move old completed tasks into per-year archive files
+  MAINTAIN,      // incremental vacuum, ANALYZE and PRAGMA optimize
+  IMPORT,        // bulk load todo.txt, CSV or JSONL
+  EXPORT,        // stream tasks and history out as CSV or JSONL
+  BACKUP,        // online page-by-page copy of the database
+  RESTORE,       // replace the database with a checked backup
+  VERIFY_COUNTERS, // recount the trigger-maintained counters and repair drift
+  STORE,         // register, list and remove named stores
+  FEDERATED,     // list, count or search every registered store at once
   ERROR,
 };
 
@@ -26,6 +41,7 @@ struct ParsedCommand {
 void lower(std::string& str);
 std::string joinArguments(int argc, char* argv[], int startIndex);
 ParsedCommand parseCommand(int argc, char* argv[]);
-void executeCommand(const ParsedCommand& command);
+// Runs the command on `db`. Returns false if it failed; main() turns that into exit status 1.
+bool executeCommand(Database& db, const ParsedCommand& command);
 
 
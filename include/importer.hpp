@@ -0,0 +1,22 @@
+#pragma once
+
+#include "flags.hpp"
+
+class Database;
+
+// `nudge import [--format=todotxt|csv|jsonl] [--batch=N] <file|->`
+//
+// A parser thread streams the input in constant memory and hands records over
+// through a small bounded queue. The calling thread is the only one that
+// touches SQLite: it inserts every record through one reused prepared
+// statement and commits every N rows. Creation/completion timestamps and the
+// completion state are kept when the input has them.
+//
+//   todotxt  `x 2024-03-02 2024-03-01 (A) text`; the dates and the `x` are optional
+//   csv      header row naming any of task, status, created_at, completed_at
+//   jsonl    one object per line with the same keys; "completed": true also works
+//
+// Timestamps are epoch seconds or local `YYYY-MM-DD[ HH:MM[:SS]]`.
+namespace importer {
+  bool importTasks(Database& db, const ParsedCommand& pc);
+} // importer
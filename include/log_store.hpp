@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+#include "task_store.hpp"
+
+// TaskStore for write-heavy use (backend = log): every add, complete and
+// delete is one record appended to ~/.nudge/tasks.log, so a write never
+// rewrites existing data.
+//
+// tasks.log   8-byte magic and a random 64-bit generation, then records framed
+//             as [crc32][length][payload]. The CRC covers length and payload.
+//             A payload is type, id and time, plus the text for an add.
+// tasks.idx   memory-mapped table with one fixed-size slot per id (slot id - 1).
+//             A slot holds the log offset and length of the task's text, its
+//             status and its times. The header records the log generation
+//             and how many log bytes the slots already reflect.
+// tasks.lock  held with flock() for the lifetime of the store: exclusive for
+//             read-write access, shared for read-only access unless the
+//             index has to be brought up to date first.
+//
+// The index is a cache of the log. On open, records past the covered offset
+// are replayed into it and the header's pending and live-byte counts are
+// recounted from the slots, which a crash may have left ahead of the header.
+// A torn record at the tail (bad CRC or short read) is truncated away. An
+// index from another generation, or one that does not fit the log, is
+// rebuilt from the whole log. Pending counts and listings are served from the
+// slots; text is read from the mapped log.
+//
+// Each mutating call appends its records in one write(). Unless synchronous =
+// off it then fdatasync()s the log and msync()s the slots before advancing
+// the covered offset, so the index never points past durable log data. Once
+// the log is more than twice the size of a fresh copy, it is compacted:
+// written out again with one snapshot record per live task and renamed into
+// place under a new generation.
+//
+// Files use host byte order.
+class LogStore : public TaskStore {
+  public:
+    // Read-only access lets several readers share the store and makes every
+    // mutating call throw.
+    explicit LogStore(Access access = Access::ReadWrite);
+    ~LogStore() override;
+
+    LogStore(const LogStore&) = delete;
+    LogStore& operator=(const LogStore&) = delete;
+
+    long long add(std::string_view text) override;
+    bool remove(long long id) override;
+    std::optional<Task> completeById(long long id) override;
+    long long completeByIds(std::span<const long long> ids, const TaskVisitor& visit) override;
+    long long completeMatching(std::string_view pattern, const TaskVisitor& visit) override;
+    long long completeOlderThan(long long seconds, const TaskVisitor& visit) override;
+    std::optional<Task> firstPending() override;
+    void forEachPending(const TaskVisitor& visit) override;
+    long long countPending() override;
+
+    // Rewrites the log with only live tasks and rebuilds the index.
+    void compact();
+
+    struct Header {
+      char magic[8];
+      std::uint64_t generation;
+      std::uint64_t covered;   // log bytes reflected in the slots
+      std::uint64_t slots;     // highest id ever assigned
+      std::uint64_t pending;
+      std::uint64_t liveBytes; // size of a compacted log
+      std::uint64_t reserved[2];
+    };
+
+    struct Slot {
+      std::uint64_t textOffset;
+      std::int64_t createdAt;
+      std::int64_t completedAt;
+      std::uint32_t state;     // SlotState
+      std::uint32_t textLength;
+    };
+
+  private:
+    void lock(int operation);
+    bool indexIsCurrent() const;
+    void requireWritable() const;
+    void openLog();
+    void openIndex();
+    void mapLog();
+    void mapIndex(std::size_t capacity);
+    void resetIndex();
+    void replay(std::uint64_t from);
+    void recount();
+    void apply(std::uint8_t type, std::int64_t id, std::int64_t time, std::uint64_t textOffset,
+               std::uint32_t textLength, std::int64_t completedAt);
+    void ensureCapacity(std::uint64_t slots);
+
+    Slot slot(long long id) const;
+    void stage(long long id, const Slot& updated);
+    Task taskAt(long long id, const Slot& s) const;
+    std::string_view textAt(std::uint64_t offset, std::uint32_t length) const;
+
+    void appendRecord(std::uint8_t type, std::int64_t id, std::int64_t time, std::string_view text = {},
+                      std::int64_t completedAt = 0);
+    void completeSlot(long long id, std::int64_t when, const TaskVisitor& visit);
+    void commit();
+
+    bool readOnly = false;
+    int lockFd = -1;
+    int logFd = -1;
+    std::uint64_t generation = 0;
+    int indexFd = -1;
+    const char* logMap = nullptr;
+    std::size_t logMapped = 0;
+    std::uint64_t logSize = 0;
+    Header* header = nullptr;
+    Slot* slotTable = nullptr;
+    std::size_t indexCapacity = 0;
+
+    // Records and slot changes of the call in progress, applied by commit().
+    std::string pendingRecords;
+    std::unordered_map<long long, Slot> staged;
+    Header next{};
+    mutable std::string textBuffer;
+};
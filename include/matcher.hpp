@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string_view>
+
+struct sqlite3;
+
+// Case-insensitive substring matching for task patterns, exposed to SQL as
+// nudge_contains(text, needle).
+//
+// ASCII needles take a vectorized path (AVX2 when the CPU has it, SSE2
+// otherwise, scalar elsewhere) that folds A-Z on the fly. A needle containing
+// UTF-8 falls back to decoding both strings and folding Latin-1, Latin
+// Extended-A, Greek and Cyrillic letters as well.
+namespace matcher {
+  bool containsIgnoreCase(std::string_view haystack, std::string_view needle);
+
+  // The ASCII search kernels containsIgnoreCase() chooses between, exposed so
+  // tests can check every one the CPU supports. `lowerNeedle` must be
+  // non-empty, ASCII and already lower-cased.
+  enum class Kernel {
+    Scalar,
+    Sse2,
+    Avx2,
+  };
+  bool kernelSupported(Kernel kernel);
+  bool asciiContains(Kernel kernel, std::string_view haystack, std::string_view lowerNeedle);
+
+  // Registers nudge_contains() on `db`. Returns an SQLite result code.
+  int registerFunctions(sqlite3* db);
+} // matcher
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <optional>
+
+#include "task_store.hpp"
+
+// TaskStore held entirely in process memory and lost on exit. Ids start at 1
+// and are never reused, so a task lives in slot id - 1 of one vector; deleted
+// tasks leave an empty slot. Scans start at the oldest task that can still be
+// pending, which only ever moves forward.
+class MemoryStore : public TaskStore {
+  public:
+    long long add(std::string_view text) override;
+    bool remove(long long id) override;
+    std::optional<Task> completeById(long long id) override;
+    long long completeByIds(std::span<const long long> ids, const TaskVisitor& visit) override;
+    long long completeMatching(std::string_view pattern, const TaskVisitor& visit) override;
+    long long completeOlderThan(long long seconds, const TaskVisitor& visit) override;
+    std::optional<Task> firstPending() override;
+    void forEachPending(const TaskVisitor& visit) override;
+    long long countPending() override;
+
+  private:
+    Task* pendingTask(long long id);
+    void complete(Task& task, long long when);
+    void skipSettled();
+
+    std::vector<std::optional<Task>> slots;
+    std::size_t firstOpen = 0;
+    long long pending = 0;
+};
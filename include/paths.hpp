@@ -8,8 +8,30 @@ namespace Paths {
    
   inline constexpr std::string conifgDirectoryName = ".nudge";
   inline constexpr std::string dbName = "list.db";
+  inline constexpr std::string socketName = "nudged.sock";
+  inline constexpr std::string configName = "config";
+  inline constexpr std::string archiveDirectoryName = "archive";
+  inline constexpr std::string backupDirectoryName = "backups";
+  inline constexpr std::string logName = "tasks.log";
+  inline constexpr std::string logIndexName = "tasks.idx";
+  inline constexpr std::string logLockName = "tasks.lock";
+  inline constexpr std::string storesName = "stores";
 
-  inline const auto configDirectoryPath = getHome() / conifgDirectoryName;
-  inline const auto dbPath = configDirectoryPath / dbName;
+  // Resolved on first use instead of during static initialization.
+  const std::filesystem::path& configDirectoryPath();
+  const std::filesystem::path& dbPath();
+  const std::filesystem::path& socketPath();
+  const std::filesystem::path& configPath();
+  const std::filesystem::path& archiveDirectoryPath();
+  const std::filesystem::path& backupDirectoryPath();
+  // Files of the append-only log backend (backend = log).
+  const std::filesystem::path& logPath();
+  const std::filesystem::path& logIndexPath();
+  const std::filesystem::path& logLockPath();
+  // Registry of named task databases that `nudge all` reads together.
+  const std::filesystem::path& storesPath();
+
+  // Completed tasks archived out of the main database, one file per (UTC) year.
+  std::filesystem::path archivePath(int year);
 
 }
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <optional>
+
+#include "flags.hpp"
+#include "database.hpp"
+
+// Optional resident server ("nudged"). It keeps one warm session, with its
+// statement cache and page cache, and serves commands over a Unix domain socket
+// at Paths::socketPath(). The CLI forwards each ParsedCommand to it when it is
+// running and falls back to executing the command itself when it is not.
+//
+// Wire format, one request per connection, native byte order (same host only):
+//   request:  magic 'N', version, flag, reserved (1 byte each), description length (uint32),
+//             hash of the client's effective settings (uint64), description bytes,
+//             plus the client's stdout and stderr passed as SCM_RIGHTS so output goes straight to them
+//   response: one status byte, the command's exit status, or 0xFF when the daemon
+//             declined the request (settings differ) and the client should run it itself
+//
+// The socket is created owner-only and the daemon serves only its own user
+// (SO_PEERCRED), with a timeout on every client read and write.
+namespace server {
+  // Returns the command's exit status, or nullopt if no daemon accepted the
+  // request; the caller should then run it directly.
+  std::optional<int> forward(const ParsedCommand& pc);
+
+  // Serves requests on `db` until SIGINT or SIGTERM. Returns the process exit code.
+  int run(Database& db);
+} // server
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <string_view>
+
+// PRAGMA synchronous level for read-write sessions. The database runs in WAL
+// mode, where the trade-off is:
+//   FULL   - fsync on every commit; a committed task survives power loss.
+//   NORMAL - fsync only at checkpoints; never corrupts the file, but the last
+//            few commits can be lost on power loss or an OS crash (not on a
+//            plain process crash).
+//   OFF    - no fsync at all; an OS crash or power loss can corrupt the file.
+enum class Synchronous {
+  Off,
+  Normal,
+  Full,
+};
+
+// PRAGMA temp_store: where sorts and temporary B-trees live.
+enum class TempStore {
+  Default,
+  File,
+  Memory,
+};
+
+// PRAGMA auto_vacuum. INCREMENTAL keeps freed pages on a freelist that
+// `nudge maintain` hands back to the filesystem a slice at a time.
+enum class AutoVacuum {
+  None,
+  Incremental,
+};
+
+// Where tasks live. SQLITE is list.db; LOG is the append-only record log in
+// tasks.log with its memory-mapped index (see log_store.hpp).
+enum class Backend {
+  Sqlite,
+  Log,
+};
+
+// Connection tuning read from Paths::configPath(). Unset values leave SQLite's
+// own default in place.
+struct Settings {
+  std::string preset;
+  Synchronous synchronous = Synchronous::Normal;
+  std::optional<int> cacheSize;            // pages when positive, KiB when negative
+  std::optional<long long> mmapSize;       // bytes of the file to memory-map
+  std::optional<int> pageSize;             // only takes effect when the database is created
+  std::optional<TempStore> tempStore;
+  AutoVacuum autoVacuum = AutoVacuum::Incremental; // at creation, or on `nudge maintain --full`
+  bool inMemory = false;                   // load the whole file into memory for each command
+  Backend backend = Backend::Sqlite;
+  bool configLoaded = false;
+};
+
+namespace settings {
+  // Effective settings for this process, resolved on first use from the config
+  // file. NUDGE_SYNCHRONOUS=off|normal|full overrides the synchronous level and
+  // NUDGE_IN_MEMORY=on|off overrides in_memory and NUDGE_BACKEND=sqlite|log
+  // overrides backend.
+  //
+  // Config file format, one `key = value` per line, '#' starts a comment:
+  //   preset      = small | large-archive   (applied first; other keys override it)
+  //   synchronous = off | normal | full
+  //   cache_size  = <int>
+  //   mmap_size   = <bytes>
+  //   page_size   = <bytes, power of two 512..65536>
+  //   temp_store  = default | file | memory
+  //   auto_vacuum = none | incremental
+  //   in_memory   = on | off
+  //   backend     = sqlite | log
+  const Settings& current();
+
+  // Every effective setting in one string, e.g. for the daemon to tell whether
+  // a client resolved the same settings it did.
+  std::string fingerprint(const Settings& settings);
+
+  std::string_view name(Synchronous level);
+  std::string_view name(TempStore store);
+  std::string_view name(AutoVacuum mode);
+  std::string_view name(Backend backend);
+} // settings
@@ -1,4 +1,8 @@
 #pragma once
 
-void initializeApplication();
+#include "flags.hpp"
+#include "database.hpp"
 
+// Opens the session for `pc`, read-only when the command never writes, creating
+// or migrating the database first if needed.
+Database initializeApplication(const ParsedCommand& pc);
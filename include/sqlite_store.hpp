@@ -0,0 +1,25 @@
+#pragma once
+
+#include "task_store.hpp"
+
+class Database;
+
+// TaskStore on the session's SQLite connection. Every operation is one cached
+// statement from Queries, so plans stay covered by check-plans.
+class SqliteStore : public TaskStore {
+  public:
+    explicit SqliteStore(Database& db) : db(db) {}
+
+    long long add(std::string_view text) override;
+    bool remove(long long id) override;
+    std::optional<Task> completeById(long long id) override;
+    long long completeByIds(std::span<const long long> ids, const TaskVisitor& visit) override;
+    long long completeMatching(std::string_view pattern, const TaskVisitor& visit) override;
+    long long completeOlderThan(long long seconds, const TaskVisitor& visit) override;
+    std::optional<Task> firstPending() override;
+    void forEachPending(const TaskVisitor& visit) override;
+    long long countPending() override;
+
+  private:
+    Database& db;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <span>
+#include <memory>
+#include <string>
+#include <optional>
+#include <functional>
+#include <string_view>
+
+#include "database.hpp"
+
+// One task as every backend hands it out. Times are UTC epoch seconds.
+struct Task {
+  long long id = 0;
+  std::string text;
+  TaskStatus status = TaskStatus::Pending;
+  long long createdAt = 0;
+  std::optional<long long> completedAt;
+};
+
+// Called once per task by the operations that return many rows, so a backend
+// can stream them instead of building a list first.
+using TaskVisitor = std::function<void(const Task&)>;
+
+// The task operations the commands need, independent of the storage engine.
+// SqliteStore is the default, LogStore the append-only `backend = log`, and
+// MemoryStore keeps everything in process memory as a baseline for benchmarks.
+// tests/task_store_conformance.cpp runs the same cases against all three.
+// Backends report failures by throwing DatabaseException, like the rest of
+// database::.
+class TaskStore {
+  public:
+    virtual ~TaskStore() = default;
+
+    // Adds a pending task and returns its id.
+    virtual long long add(std::string_view text) = 0;
+    // Deletes a pending task. False when there is no pending task with that id.
+    virtual bool remove(long long id) = 0;
+
+    // Completes one pending task and returns it, or nothing when there is no
+    // pending task with that id.
+    virtual std::optional<Task> completeById(long long id) = 0;
+    // The other complete* calls mark pending tasks completed, visit every task
+    // they completed (in no particular order) and return how many there were.
+    virtual long long completeByIds(std::span<const long long> ids, const TaskVisitor& visit) = 0;
+    // Case-insensitive substring match, as matcher::containsIgnoreCase.
+    virtual long long completeMatching(std::string_view pattern, const TaskVisitor& visit) = 0;
+    // Tasks created more than `seconds` ago.
+    virtual long long completeOlderThan(long long seconds, const TaskVisitor& visit) = 0;
+
+    // The oldest pending task, if any.
+    virtual std::optional<Task> firstPending() = 0;
+    // Pending tasks, newest first.
+    virtual void forEachPending(const TaskVisitor& visit) = 0;
+    virtual long long countPending() = 0;
+};
+
+// The store selected by the `backend` setting: SqliteStore on `db`, or the
+// append-only LogStore, opened read-only when `db` is.
+std::unique_ptr<TaskStore> openTaskStore(Database& db);
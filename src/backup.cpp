@@ -0,0 +1,268 @@
+#include <print>
+#include <format>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "sqlite3.h"
+#include "paths.hpp"
+#include "flags.hpp"
+#include "database.hpp"
+#include "backup.hpp"
+
+namespace {
+  constexpr int DEFAULT_PAGES_PER_STEP = 256;
+  constexpr int DEFAULT_KEEP = 7;
+  // Pause between steps; long enough for a waiting writer to get the lock.
+  constexpr int STEP_PAUSE_MS = 10;
+  constexpr std::string_view BACKUP_PREFIX = "list-";
+  constexpr std::string_view BACKUP_SUFFIX = ".db";
+
+  struct Options {
+    int pagesPerStep = DEFAULT_PAGES_PER_STEP;
+    int keep = DEFAULT_KEEP;
+    std::string path;
+  };
+
+  // More pages per step, or backups to keep, than an int holds is the same as all of them.
+  int positiveInt(const std::string& option, const std::string& value) {
+    return static_cast<int>(std::min<long long>(database::positiveNumber(option, value), std::numeric_limits<int>::max()));
+  }
+
+  Options parseOptions(const std::string& description) {
+    Options options;
+    std::vector<std::string> rest;
+    std::istringstream in(description);
+    std::string word;
+    while (in >> word) {
+      if (!word.starts_with("--")) {
+        rest.push_back(word);
+        continue;
+      }
+
+      std::string option = word;
+      std::string value;
+      if (auto eq = word.find('='); eq != std::string::npos) {
+        option = word.substr(0, eq);
+        value = word.substr(eq + 1);
+      } else {
+        in >> value;
+      }
+
+      if (option == "--pages") {
+        options.pagesPerStep = positiveInt(option, value);
+      } else if (option == "--keep") {
+        options.keep = positiveInt(option, value);
+      } else {
+        throw DatabaseException(std::format("Unknown option '{}'.", option));
+      }
+    }
+
+    for (const auto& part : rest) {
+      if (!options.path.empty()) {
+        options.path.push_back(' ');
+      }
+      options.path += part;
+    }
+    return options;
+  }
+
+  DatabasePtr openFile(const std::filesystem::path& path, int flags) {
+    sqlite3* raw_db = nullptr;
+    int rc = sqlite3_open_v2(path.c_str(), &raw_db, flags, nullptr);
+    DatabasePtr file(raw_db);
+    if (rc != SQLITE_OK) {
+      throw DatabaseException(std::format("Cannot open {} (code: {}): {}", path.string(), rc,
+                                          raw_db ? sqlite3_errmsg(raw_db) : "Unknown error"));
+    }
+    return file;
+  }
+
+  // PRAGMA quick_check returns a single "ok" row when the file is sound.
+  void quickCheck(sqlite3* db, const std::filesystem::path& path) {
+    sqlite3_stmt* raw_stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "PRAGMA quick_check;", -1, &raw_stmt, nullptr) != SQLITE_OK) {
+      throw DatabaseException(std::format("{} failed quick_check: {}", path.string(), sqlite3_errmsg(db)));
+    }
+    StatementPtr stmt(raw_stmt);
+
+    std::vector<std::string> problems;
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+      const char* line = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 0));
+      if (!line || std::string_view(line) != "ok") {
+        problems.emplace_back(line ? line : "?");
+      }
+    }
+    if (rc != SQLITE_DONE) {
+      throw DatabaseException(std::format("{} failed quick_check: {}", path.string(), sqlite3_errmsg(db)));
+    }
+    if (!problems.empty()) {
+      throw DatabaseException(std::format("{} failed quick_check: {}", path.string(), problems.front()));
+    }
+  }
+
+  int userVersion(sqlite3* db) {
+    sqlite3_stmt* raw_stmt = nullptr;
+    sqlite3_prepare_v2(db, Queries::SCHEMA_VERSION_QUERY.data(), -1, &raw_stmt, nullptr);
+    StatementPtr stmt(raw_stmt);
+    return stmt && sqlite3_step(stmt.get()) == SQLITE_ROW ? sqlite3_column_int(stmt.get(), 0) : 0;
+  }
+
+  // Runs a backup from `source` into `dest`, `pagesPerStep` pages at a time
+  // (-1 copies everything in one step). Progress goes to stderr on a terminal.
+  void copyPages(sqlite3* dest, sqlite3* source, int pagesPerStep) {
+    sqlite3_backup* copy = sqlite3_backup_init(dest, "main", source, "main");
+    if (!copy) {
+      throw DatabaseException(std::format("Cannot start backup: {}", sqlite3_errmsg(dest)));
+    }
+
+    const bool terminal = isatty(fileno(stderr));
+    int rc;
+    do {
+      rc = sqlite3_backup_step(copy, pagesPerStep);
+      if (terminal) {
+        const int total = sqlite3_backup_pagecount(copy);
+        const int done = total - sqlite3_backup_remaining(copy);
+        std::print(stderr, "\r  {} / {} pages ({}%)", done, total, total > 0 ? done * 100 / total : 100);
+      }
+      if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+        sqlite3_sleep(STEP_PAUSE_MS);
+      }
+    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+    if (terminal) {
+      std::println(stderr, "");
+    }
+
+    const int pages = sqlite3_backup_pagecount(copy);
+    sqlite3_backup_finish(copy);
+    if (rc != SQLITE_DONE) {
+      throw DatabaseException(std::format("Backup failed (code: {}): {}", rc, sqlite3_errstr(rc)));
+    }
+    std::println("Copied {} pages.", pages);
+  }
+
+  std::string timestampedName() {
+    const std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char buffer[32];
+    std::size_t length = std::strftime(buffer, sizeof(buffer), "%Y%m%d-%H%M%S", &local);
+    return std::format("{}{}{}", BACKUP_PREFIX, std::string_view(buffer, length), BACKUP_SUFFIX);
+  }
+
+  // Deletes all but the newest `keep` timestamped backups in `directory`.
+  void rotate(const std::filesystem::path& directory, int keep) {
+    std::vector<std::filesystem::path> backups;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+      const std::string name = entry.path().filename().string();
+      if (entry.is_regular_file() && name.starts_with(BACKUP_PREFIX) && name.ends_with(BACKUP_SUFFIX)) {
+        backups.push_back(entry.path());
+      }
+    }
+
+    // The timestamp format sorts lexically in time order.
+    std::sort(backups.rbegin(), backups.rend());
+    for (std::size_t i = static_cast<std::size_t>(keep); i < backups.size(); i++) {
+      std::filesystem::remove(backups[i]);
+      std::println("Removed old backup {}", backups[i].string());
+    }
+  }
+} // private namespace
+
+namespace backup {
+  bool create(Database& db, const ParsedCommand& pc) {
+    try {
+      const Options options = parseOptions(pc.description);
+      const auto started = std::chrono::steady_clock::now();
+
+      std::filesystem::path dest = options.path.empty() ? Paths::backupDirectoryPath() : std::filesystem::path(options.path);
+      const bool intoDirectory = options.path.empty() || options.path.ends_with('/') || std::filesystem::is_directory(dest);
+      if (intoDirectory) {
+        std::filesystem::create_directories(dest);
+        dest /= timestampedName();
+      }
+
+      // Build the copy next to the target and rename it into place once it checks out,
+      // so an interrupted backup never replaces a good file with half of one.
+      std::filesystem::path partial = dest;
+      partial += ".partial";
+      std::filesystem::remove(partial);
+      try {
+        {
+          DatabasePtr file = openFile(partial, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+          copyPages(file.get(), db.get(), options.pagesPerStep);
+          quickCheck(file.get(), partial);
+        }
+        // The copy still says WAL in its header; a stray -wal file must not outlive it.
+        std::filesystem::remove(partial.string() + "-wal");
+        std::filesystem::remove(partial.string() + "-shm");
+        std::filesystem::rename(partial, dest);
+      } catch (...) {
+        std::error_code ec;
+        std::filesystem::remove(partial, ec);
+        throw;
+      }
+
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+      std::println("Backed up {} to {} in {:.2f} s.", Paths::dbPath().string(), dest.string(), seconds);
+
+      if (intoDirectory) {
+        rotate(dest.parent_path(), options.keep);
+      }
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error backing up: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in backup: {}", e.what());
+      return false;
+    }
+  }
+
+  bool restore(Database& db, const ParsedCommand& pc) {
+    try {
+      const Options options = parseOptions(pc.description);
+      if (options.path.empty()) {
+        throw DatabaseException("No backup file given.");
+      }
+      const std::filesystem::path source = options.path;
+      if (!std::filesystem::is_regular_file(source)) {
+        throw DatabaseException(std::format("{} is not a file.", source.string()));
+      }
+
+      DatabasePtr file = openFile(source, SQLITE_OPEN_READONLY);
+      quickCheck(file.get(), source);
+      const int version = userVersion(file.get());
+      if (version <= 0 || version > Queries::SCHEMA_VERSION) {
+        throw DatabaseException(std::format("{} is not a Nudge database this build can read (schema version {}).",
+                                            source.string(), version));
+      }
+
+      // One step: the live file is locked for the whole copy, so no other
+      // connection ever sees it half restored.
+      copyPages(db.get(), file.get(), -1);
+      quickCheck(db.get(), Paths::dbPath());
+      database::setupTables(db);
+
+      std::println("Restored {} from {}.", Paths::dbPath().string(), source.string());
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error restoring: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in restore: {}", e.what());
+      return false;
+    }
+  }
+} // backup
@@ -4,13 +4,76 @@
 #include <sstream>
 #include <iostream>
 #include <string_view> 
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <limits>
+#include <cstdio>
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <charconv>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "paths.hpp"
 #include "sqlite3.h"
 #include "flags.hpp"
 #include "database.hpp" 
+#include "settings.hpp"
+#include "matcher.hpp"
+#include "task_store.hpp"
 
 namespace {
+  constexpr int BUSY_TIMEOUT_MS = 5000;
+
+  void execPragma(sqlite3* db, const std::string& pragma) {
+    sqlite3_exec(db, pragma.c_str(), nullptr, nullptr, nullptr);
+  }
+
+  // Per-connection tuning from the config file; page_size is handled at creation in setupTables().
+  void applyConnectionSettings(sqlite3* db, Access access, const Settings& config) {
+    if (access == Access::ReadWrite) {
+      execPragma(db, std::format("PRAGMA synchronous = {};", settings::name(config.synchronous)));
+    }
+    if (config.cacheSize) {
+      execPragma(db, std::format("PRAGMA cache_size = {};", *config.cacheSize));
+    }
+    if (config.mmapSize) {
+      execPragma(db, std::format("PRAGMA mmap_size = {};", *config.mmapSize));
+    }
+    if (config.tempStore) {
+      execPragma(db, std::format("PRAGMA temp_store = {};", settings::name(*config.tempStore)));
+    }
+  }
+
+  // Reads a single-value PRAGMA as text for display.
+  std::string pragmaValue(Database& db, std::string_view pragma) {
+    auto stmt = db.prepare(std::format("PRAGMA {};", pragma));
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+      return "?";
+    }
+    const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 0));
+    return value ? value : "";
+  }
+
+  constexpr int SEARCH_RESULT_LIMIT = 50;
+
+  std::string_view statusName(int status) {
+    switch (static_cast<TaskStatus>(status)) {
+      case TaskStatus::Pending:
+        return "pending";
+      case TaskStatus::Completed:
+        return "done";
+    }
+    return "unknown";
+  }
+
   int stringToId(const std::string& str) {
     try {
       return std::stoi(str);
@@ -20,13 +83,672 @@ namespace {
       throw DatabaseException(std::format("Task ID out of range: '{}'.", str));
     }
   }
+
+  // SQLite URI filenames treat '?', '#' and '%' specially, so escape them in the path.
+  std::string uriPath(const std::filesystem::path& path) {
+    std::string uri;
+    for (char c : path.string()) {
+      if (c == '?' || c == '#' || c == '%') {
+        uri += std::format("%{:02X}", static_cast<unsigned char>(c));
+      } else {
+        uri.push_back(c);
+      }
+    }
+    return uri;
+  }
+
+  void ltrim(std::string& s) {
+    s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char ch) { return !std::isspace(ch); }));
+  }
+
+  void rtrim(std::string& s) {
+    s.erase(std::find_if(s.rbegin(), s.rend(), [](unsigned char ch) { return !std::isspace(ch); }).base(), s.end());
+  }
+
+  // Lists one task a completing call just finished.
+  void reportCompleted(const Task& task) {
+    std::println("{:<3} | {}", task.id, task.text.empty() ? "(No Description)" : task.text);
+  }
+
+  // Completes every pending task whose text contains `pattern`, ignoring case.
+  void completeMatching(TaskStore& store, const std::string& pattern) {
+    if (store.completeMatching(pattern, reportCompleted) == 0) {
+      throw DatabaseException(std::format("No tasks matched pattern '{}'.", pattern));
+    }
+  }
+
+  // Recognises an ID list such as "3,7,12" or "3 7 12".
+  std::optional<std::vector<long long>> idList(std::string_view text) {
+    constexpr std::string_view digits = "0123456789";
+    if (text.find_first_not_of("0123456789, \t") != std::string_view::npos ||
+        text.find_first_of(", \t") == std::string_view::npos) {
+      return std::nullopt;
+    }
+
+    std::vector<long long> ids;
+    std::size_t pos = 0;
+    while ((pos = text.find_first_of(digits, pos)) != std::string_view::npos) {
+      std::size_t end = text.find_first_not_of(digits, pos);
+      std::string number(text.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos));
+      ids.push_back(stringToId(number));
+      pos = end == std::string_view::npos ? text.size() : end;
+    }
+    return ids;
+  }
+
+  // Parses an age such as "90m", "12h", "30d" or "2w" into seconds; a bare number means days.
+  long long ageSeconds(const std::string& text) {
+    std::size_t used = 0;
+    long long amount = -1;
+    try {
+      amount = std::stoll(text, &used);
+    } catch (const std::exception&) {
+      used = 0;
+    }
+
+    std::string_view unit = std::string_view(text).substr(used);
+    long long scale = 0;
+    if (unit == "m") scale = 60;
+    else if (unit == "h") scale = 3600;
+    else if (unit.empty() || unit == "d") scale = 86400;
+    else if (unit == "w") scale = 7 * 86400;
+
+    if (amount < 0 || scale == 0) {
+      throw DatabaseException(std::format("Invalid age '{}': expected a number with an optional m, h, d or w suffix.", text));
+    }
+    return amount * scale;
+  }
+
+  constexpr long long DEFAULT_ARCHIVE_AGE_SECONDS = 90LL * 86400;
+
+  int utcYear(sqlite3_int64 epoch) {
+    const std::time_t time = static_cast<std::time_t>(epoch);
+    std::tm utc{};
+    gmtime_r(&time, &utc);
+    return utc.tm_year + 1900;
+  }
+
+  sqlite3_int64 utcYearStart(int year) {
+    const std::chrono::sys_days day = std::chrono::year{year} / std::chrono::January / 1;
+    return std::chrono::duration_cast<std::chrono::seconds>(day.time_since_epoch()).count();
+  }
+
+  // Parses a local calendar date (YYYY-MM-DD) into the epoch second it starts at.
+  sqlite3_int64 localDayStart(const std::string& text) {
+    std::tm local{};
+    std::istringstream in(text);
+    in >> std::get_time(&local, "%Y-%m-%d");
+    if (in.fail() || !in.eof()) {
+      throw DatabaseException(std::format("Invalid date '{}': expected YYYY-MM-DD.", text));
+    }
+    local.tm_isdst = -1;
+    return static_cast<sqlite3_int64>(std::mktime(&local));
+  }
+
+  // Inclusive completed_at bounds from `--from YYYY-MM-DD` / `--to YYYY-MM-DD`; either may be omitted.
+  struct DateRange {
+    sqlite3_int64 from = 0;
+    sqlite3_int64 to = std::numeric_limits<sqlite3_int64>::max();
+    bool requested = false;
+  };
+
+  enum class ListView { Pending, Completed };
+  enum class SortKey { Created, Completed, Id, Text };
+
+  std::string_view sortName(SortKey sort) {
+    switch (sort) {
+      case SortKey::Created: return "created";
+      case SortKey::Completed: return "completed";
+      case SortKey::Id: return "id";
+      case SortKey::Text: return "text";
+    }
+    return "created";
+  }
+
+  SortKey parseSortKey(const std::string& text) {
+    for (SortKey sort : {SortKey::Created, SortKey::Completed, SortKey::Id, SortKey::Text}) {
+      if (text == sortName(sort)) {
+        return sort;
+      }
+    }
+    throw DatabaseException(std::format("Unknown sort '{}': expected created, completed, id or text.", text));
+  }
+
+  // Options of `list` and `list -c`: a date range (completed only) or paging.
+  struct ListOptions {
+    DateRange range;
+    std::optional<long long> limit;
+    std::optional<SortKey> sort;
+    std::optional<std::string> after;
+
+    bool paged() const { return limit || sort || after; }
+  };
+
+  ListOptions parseListOptions(const std::string& text) {
+    ListOptions options;
+    std::istringstream in(text);
+    std::string option;
+    while (in >> option) {
+      std::string value;
+      if (auto eq = option.find('='); eq != std::string::npos) {
+        value = option.substr(eq + 1);
+        option.erase(eq);
+      } else {
+        in >> value;
+      }
+
+      if (option == "--from") {
+        options.range.from = localDayStart(value);
+        options.range.requested = true;
+      } else if (option == "--to") {
+        // Inclusive: everything up to the start of the next day.
+        std::tm day{};
+        const std::time_t start = static_cast<std::time_t>(localDayStart(value));
+        localtime_r(&start, &day);
+        day.tm_mday += 1;
+        day.tm_isdst = -1;
+        options.range.to = static_cast<sqlite3_int64>(std::mktime(&day)) - 1;
+        options.range.requested = true;
+      } else if (option == "--limit") {
+        long long limit = 0;
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), limit);
+        if (ec != std::errc() || end != value.data() + value.size() || limit < 1) {
+          throw DatabaseException(std::format("Invalid --limit '{}': expected a positive number.", value));
+        }
+        options.limit = limit;
+      } else if (option == "--sort") {
+        options.sort = parseSortKey(value);
+      } else if (option == "--after") {
+        if (value.empty()) {
+          throw DatabaseException("--after needs the cursor printed by the previous page.");
+        }
+        options.after = value;
+      } else {
+        throw DatabaseException(std::format("Unknown option '{}': expected --from, --to, --limit, --sort or --after.", option));
+      }
+    }
+
+    if (options.range.requested && options.paged()) {
+      throw DatabaseException("--from/--to cannot be combined with --limit, --sort or --after.");
+    }
+    return options;
+  }
+
+  // Where the previous page stopped: the listing and order it belongs to, and
+  // the sort key and id of its last row. Printed hex-encoded so it reads as one
+  // opaque token; the fields inside are `view:sort:id:key`.
+  struct Cursor {
+    ListView view = ListView::Pending;
+    SortKey sort = SortKey::Created;
+    long long id = 0;
+    std::string key;
+  };
+
+  std::string encodeCursor(const Cursor& cursor) {
+    static constexpr char hex[] = "0123456789abcdef";
+    const std::string raw = std::format("{}:{}:{}:{}", cursor.view == ListView::Pending ? "p" : "c",
+                                        sortName(cursor.sort), cursor.id, cursor.key);
+    std::string encoded;
+    encoded.reserve(raw.size() * 2);
+    for (unsigned char c : raw) {
+      encoded.push_back(hex[c >> 4]);
+      encoded.push_back(hex[c & 0xF]);
+    }
+    return encoded;
+  }
+
+  Cursor decodeCursor(const std::string& text) {
+    const DatabaseException invalid(std::format("Invalid cursor '{}'.", text));
+    if (text.size() % 2 != 0) {
+      throw invalid;
+    }
+
+    std::string raw;
+    raw.reserve(text.size() / 2);
+    for (std::size_t i = 0; i < text.size(); i += 2) {
+      unsigned byte = 0;
+      auto [end, ec] = std::from_chars(text.data() + i, text.data() + i + 2, byte, 16);
+      if (ec != std::errc() || end != text.data() + i + 2) {
+        throw invalid;
+      }
+      raw.push_back(static_cast<char>(byte));
+    }
+
+    // The key comes last and may itself contain ':'.
+    const auto first = raw.find(':');
+    const auto second = first == std::string::npos ? first : raw.find(':', first + 1);
+    const auto third = second == std::string::npos ? second : raw.find(':', second + 1);
+    if (third == std::string::npos) {
+      throw invalid;
+    }
+
+    Cursor cursor;
+    const std::string_view view(raw.data(), first);
+    if (view != "p" && view != "c") {
+      throw invalid;
+    }
+    cursor.view = view == "p" ? ListView::Pending : ListView::Completed;
+    try {
+      cursor.sort = parseSortKey(raw.substr(first + 1, second - first - 1));
+    } catch (const DatabaseException&) {
+      throw invalid;
+    }
+    auto [end, ec] = std::from_chars(raw.data() + second + 1, raw.data() + third, cursor.id);
+    if (ec != std::errc() || end != raw.data() + third) {
+      throw invalid;
+    }
+    cursor.key = raw.substr(third + 1);
+    return cursor;
+  }
+
+  // Prints `task | completed_at` rows; returns whether there were any.
+  bool printCompletedRows(Database& db, StatementCache::Lease& stmt) {
+    bool found = false;
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+      found = true;
+      const char* taskText = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 0));
+      std::string completedAt = database::formatLocalTime(sqlite3_column_int64(stmt.get(), 1));
+
+      std::println("{} |      {}", completedAt, taskText ? taskText : "(No Description)");
+    }
+
+    if (rc != SQLITE_DONE) {
+      throw DatabaseException(std::format("Error stepping through results (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+    }
+    return found;
+  }
+
+  std::string_view pageQuery(ListView view, SortKey sort) {
+    if (view == ListView::Pending) {
+      switch (sort) {
+        case SortKey::Created: return Queries::PAGE_PENDING_BY_CREATED_QUERY;
+        case SortKey::Id: return Queries::PAGE_PENDING_BY_ID_QUERY;
+        case SortKey::Text: return Queries::PAGE_PENDING_BY_TEXT_QUERY;
+        case SortKey::Completed: break;
+      }
+      throw DatabaseException("Pending tasks have no completion time; sort by created, id or text.");
+    }
+
+    switch (sort) {
+      case SortKey::Created: return Queries::PAGE_COMPLETED_BY_CREATED_QUERY;
+      case SortKey::Completed: return Queries::PAGE_COMPLETED_BY_COMPLETED_QUERY;
+      case SortKey::Id: return Queries::PAGE_COMPLETED_BY_ID_QUERY;
+      case SortKey::Text: return Queries::PAGE_COMPLETED_BY_TEXT_QUERY;
+    }
+    throw DatabaseException("Unknown sort order.");
+  }
+
+  // Prints one page of a listing in the same row format as the unpaged one,
+  // then the command for the next page if there is one. Asks for one row more
+  // than --limit to know whether to offer it; returns whether there were rows.
+  bool printPage(Database& db, ListView view, const ListOptions& options) {
+    Cursor position;
+    position.view = view;
+    position.sort = options.sort.value_or(view == ListView::Pending ? SortKey::Created : SortKey::Completed);
+    if (options.after) {
+      const Cursor after = decodeCursor(*options.after);
+      if (after.view != view) {
+        throw DatabaseException(after.view == ListView::Pending ? "That cursor belongs to `list`, not `list -c`."
+                                                                : "That cursor belongs to `list -c`, not `list`.");
+      }
+      if (options.sort && *options.sort != after.sort) {
+        throw DatabaseException(std::format("That cursor continues --sort {}, not --sort {}.",
+                                            sortName(after.sort), sortName(*options.sort)));
+      }
+      position = after;
+    }
+
+    auto stmt = db.prepare(pageQuery(view, position.sort));
+    if (position.sort == SortKey::Text) {
+      // Every text sorts at or after '', and ids start at 1.
+      const std::string& key = position.key;
+      sqlite3_bind_text(stmt.get(), 1, key.data(), static_cast<int>(key.size()), SQLITE_TRANSIENT);
+      sqlite3_bind_int64(stmt.get(), 2, options.after ? position.id : 0);
+    } else if (options.after) {
+      long long key = 0;
+      auto [end, ec] = std::from_chars(position.key.data(), position.key.data() + position.key.size(), key);
+      if (ec != std::errc() || end != position.key.data() + position.key.size()) {
+        throw DatabaseException(std::format("Invalid cursor '{}'.", *options.after));
+      }
+      sqlite3_bind_int64(stmt.get(), 1, key);
+      sqlite3_bind_int64(stmt.get(), 2, position.id);
+    } else {
+      sqlite3_bind_int64(stmt.get(), 1, std::numeric_limits<sqlite3_int64>::max());
+      sqlite3_bind_int64(stmt.get(), 2, std::numeric_limits<sqlite3_int64>::max());
+    }
+    sqlite3_bind_int64(stmt.get(), 3, options.limit ? *options.limit + 1 : -1);
+
+    long long shown = 0;
+    bool more = false;
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+      if (options.limit && shown == *options.limit) {
+        more = true;
+        break;
+      }
+      shown++;
+
+      const char* taskText = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), view == ListView::Pending ? 1 : 0));
+      const char* description = taskText && *taskText ? taskText : "(No Description)";
+      if (view == ListView::Pending) {
+        position.id = sqlite3_column_int64(stmt.get(), 0);
+        std::println("{:<3} | {:<7} | {}", position.id, statusName(static_cast<int>(TaskStatus::Pending)), description);
+      } else {
+        position.id = sqlite3_column_int64(stmt.get(), 2);
+        std::println("{} |      {}", database::formatLocalTime(sqlite3_column_int64(stmt.get(), 1)), description);
+      }
+      const char* key = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 3));
+      position.key = key ? key : "";
+    }
+
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+      throw DatabaseException(std::format("Error stepping through results (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+    }
+
+    if (more) {
+      std::println("");
+      std::println("Next page: nudge list{} --limit {} --after {}", view == ListView::Completed ? " -c" : "",
+                   *options.limit, encodeCursor(position));
+    }
+    return shown > 0;
+  }
+
+  constexpr long long MAINTENANCE_WRITE_THRESHOLD = 1000;
+  constexpr auto MAINTENANCE_SLICE = std::chrono::milliseconds(20);
+  constexpr auto DEFAULT_MAINTENANCE_BUDGET = std::chrono::milliseconds(500);
+  constexpr int INCREMENTAL_VACUUM_STEP_PAGES = 64;
+  // Rows ANALYZE samples per index; keeps it fast on large tables.
+  constexpr int ANALYSIS_LIMIT = 400;
+
+  long long pragmaInt(Database& db, std::string_view pragma) {
+    auto stmt = db.prepare(std::format("PRAGMA {};", pragma));
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+      throw DatabaseException(std::format("Error reading PRAGMA {}: {}", pragma, sqlite3_errmsg(db.get())));
+    }
+    return sqlite3_column_int64(stmt.get(), 0);
+  }
+
+  // Frees freelist pages a few at a time until none are left or `budget` runs
+  // out. Each step is its own short write transaction. Returns pages reclaimed.
+  long long incrementalVacuum(Database& db, std::chrono::steady_clock::duration budget) {
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    const long long before = pragmaInt(db, "freelist_count");
+
+    long long remaining = before;
+    while (remaining > 0 && std::chrono::steady_clock::now() < deadline) {
+      database::execOrThrow(db, std::format("PRAGMA incremental_vacuum({});", INCREMENTAL_VACUUM_STEP_PAGES));
+      const long long now = pragmaInt(db, "freelist_count");
+      if (now >= remaining) {
+        break;
+      }
+      remaining = now;
+    }
+    return before - remaining;
+  }
+
+  long long elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since).count();
+  }
+
+  // Offset of the file format write/read version bytes in the database header.
+  constexpr int WAL_FORMAT_OFFSET = 18;
+  constexpr int WRITE_BACK_RETRY_MS = 10;
+
+  // Function registration, busy timeout and config tuning shared by every connection.
+  DatabasePtr finishOpening(sqlite3* raw_db, Access access) {
+    int rc = matcher::registerFunctions(raw_db);
+    if (rc != SQLITE_OK) {
+      std::string error_detail = std::format("Failed to register SQL functions (code: {}): {}", rc, sqlite3_errmsg(raw_db));
+      sqlite3_close(raw_db);
+      throw DatabaseException(error_detail);
+    }
+
+    // Writers wait for each other instead of failing with SQLITE_BUSY; in WAL mode readers never wait.
+    sqlite3_busy_timeout(raw_db, BUSY_TIMEOUT_MS);
+
+    applyConnectionSettings(raw_db, access, settings::current());
+
+    return DatabasePtr(raw_db);
+  }
+
+  // PRAGMA data_version for `db`: it changes between two calls exactly when
+  // another connection committed to the file in between.
+  sqlite3_int64 dataVersion(sqlite3* db) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "PRAGMA data_version;", -1, &stmt, nullptr) != SQLITE_OK) {
+      throw DatabaseException(std::format("Cannot read data_version: {}", sqlite3_errmsg(db)));
+    }
+    const int rc = sqlite3_step(stmt);
+    const sqlite3_int64 version = rc == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : -1;
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_ROW) {
+      throw DatabaseException(std::format("Cannot read data_version: {}", sqlite3_errmsg(db)));
+    }
+    return version;
+  }
+
+  // True when the WAL still holds commits that are not in the main file.
+  bool walHasFrames() {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(Paths::dbPath().string() + "-wal", ec);
+    return !ec && size > 0;
+  }
+
+  // Reads a whole file with one sequential read into memory that SQLite can take
+  // ownership of. A missing or empty file gives a null image of size 0.
+  unsigned char* readWholeFile(const std::filesystem::path& path, sqlite3_int64& size) {
+    size = 0;
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return nullptr;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+      close(fd);
+      return nullptr;
+    }
+
+    auto* image = static_cast<unsigned char*>(sqlite3_malloc64(static_cast<sqlite3_uint64>(info.st_size)));
+    if (!image) {
+      close(fd);
+      throw DatabaseException(std::format("Out of memory loading {} ({} bytes)", path.string(), info.st_size));
+    }
+
+    sqlite3_int64 done = 0;
+    while (done < info.st_size) {
+      const ssize_t n = read(fd, image + done, static_cast<std::size_t>(info.st_size - done));
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        const int error = errno;
+        close(fd);
+        sqlite3_free(image);
+        throw DatabaseException(std::format("Cannot read {}: {}", path.string(), n == 0 ? "unexpected end of file" : std::strerror(error)));
+      }
+      done += n;
+    }
+    close(fd);
+
+    size = done;
+    return image;
+  }
 };
 
+StatementCache::Lease::~Lease() {
+  if (stmt) {
+    sqlite3_reset(stmt.get());
+    sqlite3_clear_bindings(stmt.get());
+    pool->push_back(std::move(stmt));
+  }
+}
+
+StatementCache::Lease StatementCache::acquire(std::string_view query) {
+  auto& pool = idle[std::string(query)];
+
+  if (!pool.empty()) {
+    counters.hits++;
+    StatementPtr stmt = std::move(pool.back());
+    pool.pop_back();
+    return Lease(&pool, std::move(stmt));
+  }
+
+  counters.misses++;
+  sqlite3_stmt* raw_stmt = nullptr;
+  int rc = sqlite3_prepare_v3(db, query.data(), static_cast<int>(query.size()), SQLITE_PREPARE_PERSISTENT, &raw_stmt,
+                              nullptr);
+  if (rc != SQLITE_OK) {
+    throw DatabaseException(std::format("Error preparing statement (code: {}): {}", rc, sqlite3_errmsg(db)));
+  }
+
+  return Lease(&pool, StatementPtr(raw_stmt));
+}
+
+Database::Database(Access access, bool inMemory) :
+    mode(access),
+    handle(inMemory ? database::openInMemory(access, disk) : database::openDatabase(access)),
+    statements(handle.get()) {}
+
+Transaction::Transaction(Database& db, std::string_view begin) : db(db) {
+  // A BEGIN that fails (e.g. SQLITE_BUSY after the busy timeout) leaves the
+  // connection in autocommit mode, so the caller must not carry on.
+  if (sqlite3_exec(db.get(), std::string(begin).c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+    throw DatabaseException(std::format("Failed to begin transaction: {}", sqlite3_errmsg(db.get())));
+  }
+}
+
+Transaction::~Transaction() {
+  if (!committed) {
+    sqlite3_exec(db.get(), Queries::ROLLBACK_QUERY.data(), nullptr, nullptr, nullptr);
+  }
+}
+
+void Transaction::commit() {
+  // On failure the transaction is still open; the destructor rolls it back.
+  if (sqlite3_exec(db.get(), Queries::COMMIT_QUERY.data(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+    throw DatabaseException(std::format("Failed to commit transaction: {}", sqlite3_errmsg(db.get())));
+  }
+  committed = true;
+}
+
+AttachedArchive::AttachedArchive(Database& db, const std::filesystem::path& file) : db(db) {
+  auto stmt = db.prepare(Queries::ATTACH_ARCHIVE_QUERY);
+  sqlite3_bind_text(stmt.get(), 1, file.c_str(), -1, SQLITE_TRANSIENT);
+  if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+    throw DatabaseException(std::format("Failed to attach {}: {}", file.string(), sqlite3_errmsg(db.get())));
+  }
+}
+
+AttachedArchive::~AttachedArchive() {
+  sqlite3_exec(db.get(), Queries::DETACH_ARCHIVE_QUERY.data(), nullptr, nullptr, nullptr);
+}
+
 namespace database {
+  long long positiveNumber(const std::string& option, const std::string& value) {
+    long long number = 0;
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (ec != std::errc() || end != value.data() + value.size() || number <= 0) {
+      throw DatabaseException(std::format("Invalid value '{}' for {}: expected a positive number.", value, option));
+    }
+    return number;
+  }
+
+  void execOrThrow(Database& db, std::string_view sql) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db.get(), std::string(sql).c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+      std::string error_detail = std::format("{} failed: {}", sql, errMsg ? errMsg : sqlite3_errmsg(db.get()));
+      sqlite3_free(errMsg);
+      throw DatabaseException(error_detail);
+    }
+  }
+
+  // Turns free text into an FTS5 expression: every word becomes a quoted phrase
+  // (so punctuation never trips the query parser) and a trailing '*' keeps its
+  // meaning as a prefix search, e.g. `buy mil*` -> `"buy" "mil"*`.
+  std::string ftsQuery(std::string_view text) {
+    std::string query;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+      pos = text.find_first_not_of(" \t", pos);
+      if (pos == std::string_view::npos) {
+        break;
+      }
+      std::size_t end = text.find_first_of(" \t", pos);
+      std::string_view word = text.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+      pos = end == std::string_view::npos ? text.size() : end;
+
+      bool prefix = false;
+      while (word.ends_with('*')) {
+        word.remove_suffix(1);
+        prefix = true;
+      }
+      if (word.empty()) {
+        continue;
+      }
+
+      if (!query.empty()) {
+        query.push_back(' ');
+      }
+      query.push_back('"');
+      for (char c : word) {
+        if (c == '"') {
+          query.push_back('"');
+        }
+        query.push_back(c);
+      }
+      query.push_back('"');
+      if (prefix) {
+        query.push_back('*');
+      }
+    }
+    return query;
+  }
 
-  DatabasePtr openDatabase() {
+  // Timestamps are stored as UTC epoch seconds; convert to the device's local time only for display.
+  std::string formatLocalTime(sqlite3_int64 epoch) {
+    const std::time_t time = static_cast<std::time_t>(epoch);
+    std::tm local{};
+    localtime_r(&time, &local);
+
+    char buffer[32];
+    std::size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    return std::string(buffer, length);
+  }
+
+  std::vector<int> archivedYears() {
+    std::vector<int> years;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(Paths::archiveDirectoryPath(), ec)) {
+      const std::string stem = entry.path().stem().string();
+      if (entry.path().extension() == ".db" && !stem.empty() &&
+          std::all_of(stem.begin(), stem.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        years.push_back(std::stoi(stem));
+      }
+    }
+    std::sort(years.rbegin(), years.rend());
+    return years;
+  }
+
+  DatabasePtr openDatabase(Access access) {
     sqlite3* raw_db = nullptr;
-    int rc = sqlite3_open(Paths::dbPath.c_str(), &raw_db); 
+    int rc = SQLITE_MISUSE;
+
+    switch (access) {
+      case Access::ReadWrite:
+        rc = sqlite3_open_v2(Paths::dbPath().c_str(), &raw_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+        break;
+      case Access::ReadOnly:
+        rc = sqlite3_open_v2(Paths::dbPath().c_str(), &raw_db, SQLITE_OPEN_READONLY, nullptr);
+        break;
+      case Access::Immutable:
+      case Access::NoLock: {
+        std::string uri = std::format("file:{}?{}=1", uriPath(Paths::dbPath()),
+                                      access == Access::Immutable ? "immutable" : "nolock");
+        rc = sqlite3_open_v2(uri.c_str(), &raw_db, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, nullptr);
+      } break;
+    }
 
     if (rc != SQLITE_OK) {
       const char* err_msg = raw_db ? sqlite3_errmsg(raw_db) : "Unknown error";
@@ -38,46 +760,204 @@ namespace database {
       throw DatabaseException(std::format("Failed to open/create database (code: {}): {}", rc, err_msg));
     }
 
-    return DatabasePtr(raw_db);
+    return finishOpening(raw_db, access);
   }
 
-  void setupTables() {
-    auto db = openDatabase(); 
-    char *errMsg = nullptr;
+  DatabasePtr openInMemory(Access access, DatabasePtr& disk) {
+    const bool writable = access == Access::ReadWrite;
+    disk = openDatabase(access);
+    sqlite3* file = disk.get();
 
-    int rc = sqlite3_exec(db.get(), Queries::TODO_TABLE_QUERY.data(), nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK && errMsg) {
-      std::string error_detail = std::format("Error creating TODO table: {}", errMsg);
-      sqlite3_free(errMsg);
-      throw DatabaseException(error_detail); 
+    // With the WAL checkpointed away the main file alone is the current image.
+    if (writable) {
+      execPragma(file, "PRAGMA wal_checkpoint(TRUNCATE);");
     }
 
-    rc = sqlite3_exec(db.get(), Queries::COMPLETED_TABLE_QUERY.data(), nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK && errMsg) {
-      std::string error_detail = std::format("Error creating COMPLETED table: {}", errMsg);
+    // Hold a transaction while copying so the image is one consistent snapshot.
+    // For a writer it is BEGIN IMMEDIATE and stays open until writeBack().
+    const std::string begin = writable ? std::string(Queries::BEGIN_IMMEDIATE_QUERY)
+                                       : "BEGIN; SELECT 1 FROM sqlite_schema LIMIT 1;";
+    char* errMsg = nullptr;
+    if (sqlite3_exec(file, begin.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+      std::string error_detail = std::format("Cannot lock {} for loading: {}", Paths::dbPath().string(),
+                                             errMsg ? errMsg : sqlite3_errmsg(file));
       sqlite3_free(errMsg);
       throw DatabaseException(error_detail);
     }
 
+    sqlite3_int64 size = 0;
+    unsigned char* image = walHasFrames() ? sqlite3_serialize(file, "main", &size, 0)
+                                          : readWholeFile(Paths::dbPath(), size);
+    if (!image && size > 0) {
+      throw DatabaseException(std::format("Cannot load {} into memory: {}", Paths::dbPath().string(), sqlite3_errmsg(file)));
+    }
+
+    // Header bytes 18/19 say 2 for a WAL database; an in-memory image must use
+    // the rollback journal (1), or SQLite looks for a -wal file it cannot have.
+    if (size > WAL_FORMAT_OFFSET + 1) {
+      image[WAL_FORMAT_OFFSET] = 1;
+      image[WAL_FORMAT_OFFSET + 1] = 1;
+    }
+
+    if (!writable) {
+      sqlite3_exec(file, Queries::COMMIT_QUERY.data(), nullptr, nullptr, nullptr);
+      disk.reset();
+    }
+
+    sqlite3* raw_db = nullptr;
+    int rc = sqlite3_open_v2(":memory:", &raw_db, SQLITE_OPEN_READWRITE, nullptr);
+    if (rc != SQLITE_OK) {
+      sqlite3_free(image);
+      sqlite3_close(raw_db);
+      throw DatabaseException(std::format("Failed to open in-memory database (code: {})", rc));
+    }
+
+    // An empty file needs no image: a fresh :memory: database is the same thing.
+    if (size > 0) {
+      const unsigned flags = SQLITE_DESERIALIZE_FREEONCLOSE |
+                             (writable ? SQLITE_DESERIALIZE_RESIZEABLE : SQLITE_DESERIALIZE_READONLY);
+      rc = sqlite3_deserialize(raw_db, "main", image, size, size, flags);
+      if (rc != SQLITE_OK) {
+        std::string error_detail = std::format("Failed to load {} into memory (code: {}): {}",
+                                               Paths::dbPath().string(), rc, sqlite3_errmsg(raw_db));
+        sqlite3_close(raw_db);
+        throw DatabaseException(error_detail);
+      }
+    } else {
+      sqlite3_free(image);
+    }
+
+    return finishOpening(raw_db, access);
   }
 
-  bool addTask(const ParsedCommand& pc) {
+  bool writeBack(Database& db) {
+    sqlite3* file = db.file();
+    if (!file) {
+      return true;
+    }
+
     try {
-      auto db = openDatabase(); 
+      if (sqlite3_total_changes64(db.get()) == 0) {
+        sqlite3_exec(file, Queries::ROLLBACK_QUERY.data(), nullptr, nullptr, nullptr);
+        return true;
+      }
 
-      sqlite3_stmt* raw_stmt = nullptr;
+      // A backup cannot start while its destination has a transaction open, so
+      // the write lock has to be dropped and retaken by the backup itself. A
+      // second connection notes the file's data_version while the lock is still
+      // held; once sqlite3_backup_step(0) has the lock again, a changed version
+      // means another writer committed in the gap and the copy would lose it.
+      sqlite3* raw_watch = nullptr;
+      if (sqlite3_open_v2(Paths::dbPath().c_str(), &raw_watch, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::string error_detail = std::format("Cannot open {} for write-back: {}", Paths::dbPath().string(),
+                                               sqlite3_errmsg(raw_watch));
+        sqlite3_close(raw_watch);
+        throw DatabaseException(error_detail);
+      }
+      DatabasePtr watch(raw_watch);
+      const sqlite3_int64 loadedVersion = dataVersion(watch.get());
+
+      char* errMsg = nullptr;
+      if (sqlite3_exec(file, Queries::COMMIT_QUERY.data(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::string error_detail = std::format("Cannot release {} for write-back: {}", Paths::dbPath().string(),
+                                               errMsg ? errMsg : sqlite3_errmsg(file));
+        sqlite3_free(errMsg);
+        throw DatabaseException(error_detail);
+      }
 
-      int rc = sqlite3_prepare_v2(db.get(), Queries::INSERT_TASK_QUERY.data(), -1, &raw_stmt, nullptr);
+      sqlite3_backup* copy = sqlite3_backup_init(file, "main", db.get(), "main");
+      if (!copy) {
+        throw DatabaseException(std::format("Cannot start write-back: {}", sqlite3_errmsg(file)));
+      }
+      int rc;
+      while ((rc = sqlite3_backup_step(copy, 0)) == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+        sqlite3_sleep(WRITE_BACK_RETRY_MS);
+      }
+      if (rc == SQLITE_OK && dataVersion(watch.get()) != loadedVersion) {
+        // Finishing an incomplete backup rolls the destination back untouched.
+        sqlite3_backup_finish(copy);
+        throw DatabaseException(std::format("{} changed on disk while the in-memory copy was being written back; "
+                                            "nothing was written", Paths::dbPath().string()));
+      }
+      if (rc == SQLITE_OK) {
+        rc = sqlite3_backup_step(copy, -1);
+      }
+      sqlite3_backup_finish(copy);
+      if (rc != SQLITE_DONE) {
+        throw DatabaseException(std::format("Write-back failed (code: {}): {}", rc, sqlite3_errstr(rc)));
+      }
 
-      if (rc != SQLITE_OK) {
-        throw DatabaseException(std::format("Error preparing statement (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+      // A database created in memory reaches the disk without WAL; switch it like setupTables() would.
+      sqlite3_exec(file, Queries::JOURNAL_MODE_WAL_QUERY.data(), nullptr, nullptr, nullptr);
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error writing back in-memory database: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in writeBack: {}", e.what());
+      return false;
+    }
+  }
+
+  int schemaVersion(Database& db) {
+    auto stmt = db.prepare(Queries::SCHEMA_VERSION_QUERY);
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+      throw DatabaseException(std::format("Error reading schema version: {}", sqlite3_errmsg(db.get())));
+    }
+    return sqlite3_column_int(stmt.get(), 0);
+  }
+
+  void setupTables(Database& db) {
+    // Fast path: an up-to-date database needs no DDL at all.
+    const int storedVersion = schemaVersion(db);
+    if (storedVersion == Queries::SCHEMA_VERSION) {
+      return;
+    }
+
+    // page_size and auto_vacuum only apply before the first page is written, i.e. to a brand new file.
+    if (storedVersion == 0) {
+      if (settings::current().pageSize) {
+        execPragma(db.get(), std::format("PRAGMA page_size = {};", *settings::current().pageSize));
       }
+      execPragma(db.get(), std::format("PRAGMA auto_vacuum = {};", settings::name(settings::current().autoVacuum)));
+    }
 
-      StatementPtr stmt(raw_stmt); 
-      sqlite3_bind_text(stmt.get(), 1, pc.description.c_str(), -1, SQLITE_TRANSIENT);
-      rc = sqlite3_step(stmt.get());
+    // Take the write lock before re-reading the version so concurrent first runs migrate only once.
+    Transaction transaction(db, Queries::BEGIN_IMMEDIATE_QUERY);
+    int version = schemaVersion(db);
 
-      return rc == SQLITE_DONE;
+    if (version > Queries::SCHEMA_VERSION) {
+      throw DatabaseException(std::format("Database schema version {} is newer than this build supports ({}).",
+                                          version, Queries::SCHEMA_VERSION));
+    }
+
+    for (; version < Queries::SCHEMA_VERSION; version++) {
+      for (std::string_view query : Queries::MIGRATIONS[version]) {
+        char *errMsg = nullptr;
+        int rc = sqlite3_exec(db.get(), query.data(), nullptr, nullptr, &errMsg);
+        if (rc != SQLITE_OK) {
+          std::string error_detail = std::format("Error migrating schema to version {}: {}", version + 1,
+                                                 errMsg ? errMsg : sqlite3_errmsg(db.get()));
+          sqlite3_free(errMsg);
+          throw DatabaseException(error_detail);
+        }
+      }
+    }
+
+    std::string setVersion = std::format("PRAGMA user_version = {};", Queries::SCHEMA_VERSION);
+    if (sqlite3_exec(db.get(), setVersion.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+      throw DatabaseException(std::format("Error recording schema version: {}", sqlite3_errmsg(db.get())));
+    }
+    transaction.commit();
+
+    sqlite3_exec(db.get(), Queries::JOURNAL_MODE_WAL_QUERY.data(), nullptr, nullptr, nullptr);
+  }
+
+  bool addTask(Database& db, const ParsedCommand& pc) {
+    try {
+      auto store = openTaskStore(db);
+      store->add(pc.description);
+      return true;
 
     } catch (const DatabaseException& e) {
       std::println(stderr, "DB Error adding task: {}", e.what());
@@ -86,33 +966,18 @@ namespace database {
       std::println(stderr, "General Error in addTask: {}", e.what());
       return false;
     }
-  } 
+  }
 
-  bool deleteTask(const ParsedCommand& pc) {
+  bool deleteTask(Database& db, const ParsedCommand& pc) {
     try {
       if (pc.description.empty()) {
         throw DatabaseException("Deletion failed: No task ID provided.");
       }
 
-      auto db = openDatabase(); 
       int task_id = stringToId(pc.description); // Convert ID string to int
 
-      sqlite3_stmt* raw_stmt = nullptr;
-      int rc = sqlite3_prepare_v2(db.get(), Queries::DELETE_TASK_QUERY.data(), -1, &raw_stmt, nullptr);
-      if (rc != SQLITE_OK) {
-        throw DatabaseException(std::format("Error preparing DELETE statement: {}", sqlite3_errmsg(db.get())));
-      }
-
-      StatementPtr stmt(raw_stmt); 
-      sqlite3_bind_int(stmt.get(), 1, task_id);
-
-      rc = sqlite3_step(stmt.get());
-
-      if (rc != SQLITE_DONE) {
-        throw DatabaseException(std::format("Execution failed (code: {}): {}", rc, sqlite3_errmsg(db.get())));
-      }
-
-      if (sqlite3_changes(db.get()) == 0) {
+      auto store = openTaskStore(db);
+      if (!store->remove(task_id)) {
         std::println(stderr, "Warning: No task found with ID {}.", task_id);
         return false;
       }
@@ -127,33 +992,29 @@ namespace database {
     }
   }
 
-  bool listAllTasks() {
+  bool listAllTasks(Database& db, const ParsedCommand& pc) {
     try {
-      auto db = openDatabase(); 
-      sqlite3_stmt* raw_stmt = nullptr;
-
-      int rc = sqlite3_prepare_v2(db.get(), Queries::SELECT_ALL_TASKS_QUERY.data(), -1, &raw_stmt, nullptr);
-      if (rc != SQLITE_OK) {
-        throw DatabaseException(std::format("Error preparing LIST statement: {}", sqlite3_errmsg(db.get())));
+      const ListOptions options = parseListOptions(pc.description);
+      if (options.range.requested) {
+        throw DatabaseException("--from/--to only apply to `list -c`.");
+      }
+      if (options.paged() && settings::current().backend != Backend::Sqlite) {
+        throw DatabaseException("--limit, --sort and --after need backend = sqlite.");
       }
-
-      StatementPtr stmt(raw_stmt); 
 
       bool tasks_found = false;
       std::println(" ID | Task");
       std::println("----|-------------------------------------------------------");
 
-      while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
-        tasks_found = true;
-        int id = sqlite3_column_int(stmt.get(), 0);
-        const char* task_text = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 1));
-        const char* status = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 2));
-
-        std::println("{:<3} | {:<7} | {}", id, status, task_text ? task_text : "(No Description)");
-      }
-
-      if (rc != SQLITE_DONE) {
-        throw DatabaseException(std::format("Error stepping through results (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+      if (options.paged()) {
+        tasks_found = printPage(db, ListView::Pending, options);
+      } else {
+        auto store = openTaskStore(db);
+        store->forEachPending([&](const Task& task) {
+          tasks_found = true;
+          std::string_view status = statusName(static_cast<int>(task.status));
+          std::println("{:<3} | {:<7} | {}", task.id, status, task.text.empty() ? "(No Description)" : task.text);
+        });
       }
 
       if (!tasks_found) {
@@ -170,33 +1031,19 @@ namespace database {
     }
   }
 
-  bool markTaskComplete(const ParsedCommand& pc) {
+  bool markTaskComplete(Database& db, const ParsedCommand& pc) {
     try {
-      auto db = openDatabase();
-
       // If no description provided, mark the first pending task as completed
       std::string desc = pc.description;
-      auto ltrim = [](std::string &s) {
-        s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char ch) { return !std::isspace(ch); }));
-      };
-      auto rtrim = [](std::string &s) {
-        s.erase(std::find_if(s.rbegin(), s.rend(), [](unsigned char ch) { return !std::isspace(ch); }).base(), s.end());
-      };
       ltrim(desc);
       rtrim(desc);
 
+      auto store = openTaskStore(db);
+
       if (desc.empty()) {
         // find the first pending task (oldest)
-        sqlite3_stmt* first_stmt_raw = nullptr;
-        int rc = sqlite3_prepare_v2(db.get(), "SELECT id, task FROM tasks ORDER BY created_at ASC LIMIT 1;", -1, &first_stmt_raw, nullptr);
-        if (rc != SQLITE_OK) {
-          throw DatabaseException(std::format("Failed to prepare select-first statement: {}", sqlite3_errmsg(db.get())));
-        }
-        StatementPtr first_stmt(first_stmt_raw);
-        if (sqlite3_step(first_stmt.get()) == SQLITE_ROW) {
-          int found_id = sqlite3_column_int(first_stmt.get(), 0);
-          const char* txt = reinterpret_cast<const char*>(sqlite3_column_text(first_stmt.get(), 1));
-          desc = std::to_string(found_id);
+        if (auto first = store->firstPending()) {
+          desc = std::to_string(first->id);
         } else {
           throw DatabaseException("No pending tasks to complete.");
         }
@@ -205,84 +1052,38 @@ namespace database {
       std::string lower_desc = desc;
       std::transform(lower_desc.begin(), lower_desc.end(), lower_desc.begin(), [](unsigned char c){ return std::tolower(c); });
 
-      // Begin transaction
-      sqlite3_exec(db.get(), Queries::BEGIN_TRANSACTION_QUERY.data(), 0, 0, 0);
+      // Completion flips the row's status in place, so every selector below is a
+      // single store call (one UPDATE ... RETURNING) and needs no explicit transaction.
+      if (lower_desc.rfind("--older-than", 0) == 0) {
+        std::string age = desc.substr(12); // after "--older-than"
+        ltrim(age);
+        if (!age.empty() && age.front() == '=') {
+          age.erase(0, 1);
+        }
+
+        if (store->completeOlderThan(ageSeconds(age), reportCompleted) == 0) {
+          throw DatabaseException(std::format("No pending tasks older than {}.", age));
+        }
+        return true;
+      }
 
       if (lower_desc.rfind("like ", 0) == 0) {
-        // Pattern-based completion: move all matching tasks
+        // Pattern-based completion: complete all matching tasks
         std::string pattern = desc.substr(5); // after "LIKE "
         ltrim(pattern);
         rtrim(pattern);
         if (pattern.empty()) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
           throw DatabaseException("LIKE pattern is empty.");
         }
 
-        std::string likePattern = "%" + pattern + "%";
-
-        // Prepare statements
-        sqlite3_stmt* select_stmt_raw = nullptr;
-        int rc = sqlite3_prepare_v2(db.get(), "SELECT id, task FROM tasks WHERE task LIKE ?;", -1, &select_stmt_raw, nullptr);
-        if (rc != SQLITE_OK) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Failed to prepare select LIKE statement: {}", sqlite3_errmsg(db.get())));
-        }
-        StatementPtr select_stmt(select_stmt_raw);
-        sqlite3_bind_text(select_stmt.get(), 1, likePattern.c_str(), -1, SQLITE_TRANSIENT);
-
-        sqlite3_stmt* insert_stmt_raw = nullptr;
-        rc = sqlite3_prepare_v2(db.get(), Queries::INSERT_COMPLETED_TASK_QUERY.data(), -1, &insert_stmt_raw, nullptr);
-        if (rc != SQLITE_OK) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Failed to prepare insert statement: {}", sqlite3_errmsg(db.get())));
-        }
-        StatementPtr insert_stmt(insert_stmt_raw);
-
-        sqlite3_stmt* delete_stmt_raw = nullptr;
-        rc = sqlite3_prepare_v2(db.get(), Queries::DELETE_TASK_QUERY.data(), -1, &delete_stmt_raw, nullptr);
-        if (rc != SQLITE_OK) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Failed to prepare delete statement: {}", sqlite3_errmsg(db.get())));
-        }
-        StatementPtr delete_stmt(delete_stmt_raw);
-
-        bool anyMoved = false;
-        while ((rc = sqlite3_step(select_stmt.get())) == SQLITE_ROW) {
-          anyMoved = true;
-          int id = sqlite3_column_int(select_stmt.get(), 0);
-          const char* task_text_c = reinterpret_cast<const char*>(sqlite3_column_text(select_stmt.get(), 1));
-          std::string task_text = task_text_c ? task_text_c : "";
-
-          // Insert into completed
-          sqlite3_reset(insert_stmt.get());
-          sqlite3_clear_bindings(insert_stmt.get());
-          sqlite3_bind_text(insert_stmt.get(), 1, task_text.c_str(), -1, SQLITE_TRANSIENT);
-          if (sqlite3_step(insert_stmt.get()) != SQLITE_DONE) {
-            sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-            throw DatabaseException("Failed to insert into completed table during LIKE operation.");
-          }
-
-          // Delete from tasks
-          sqlite3_reset(delete_stmt.get());
-          sqlite3_clear_bindings(delete_stmt.get());
-          sqlite3_bind_int(delete_stmt.get(), 1, id);
-          if (sqlite3_step(delete_stmt.get()) != SQLITE_DONE) {
-            sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-            throw DatabaseException("Failed to delete from tasks table during LIKE operation.");
-          }
-        }
-
-        if (rc != SQLITE_DONE) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Error iterating LIKE results: {}", sqlite3_errmsg(db.get())));
-        }
+        completeMatching(*store, pattern);
+        return true;
+      }
 
-        if (!anyMoved) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("No tasks matched pattern '{}'.", pattern));
+      if (auto ids = idList(desc)) {
+        if (store->completeByIds(*ids, reportCompleted) == 0) {
+          throw DatabaseException(std::format("No pending tasks with IDs {}.", desc));
         }
-
-        sqlite3_exec(db.get(), "COMMIT;", 0, 0, 0);
         return true;
       }
 
@@ -296,215 +1097,450 @@ namespace database {
       }
 
       if (!is_id) {
-        // Treat desc as a substring pattern and move matching tasks (same as LIKE behaviour)
-        std::string pattern = desc;
-        ltrim(pattern);
-        rtrim(pattern);
-        if (pattern.empty()) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException("Pattern is empty.");
-        }
+        // Treat desc as a substring pattern and complete matching tasks (same as LIKE behaviour)
+        completeMatching(*store, desc);
+        return true;
+      }
 
-        std::string likePattern = "%" + pattern + "%";
+      if (auto task = store->completeById(task_id)) {
+        reportCompleted(*task);
+      } else {
+        throw DatabaseException(std::format("Task with ID {} not found.", task_id));
+      }
 
-        sqlite3_stmt* select_stmt_raw = nullptr;
-        int rc = sqlite3_prepare_v2(db.get(), "SELECT id, task FROM tasks WHERE task LIKE ?;", -1, &select_stmt_raw, nullptr);
-        if (rc != SQLITE_OK) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Failed to prepare select pattern statement: {}", sqlite3_errmsg(db.get())));
-        }
-        StatementPtr select_stmt(select_stmt_raw);
-        sqlite3_bind_text(select_stmt.get(), 1, likePattern.c_str(), -1, SQLITE_TRANSIENT);
+      return true;
 
-        sqlite3_stmt* insert_stmt_raw = nullptr;
-        rc = sqlite3_prepare_v2(db.get(), Queries::INSERT_COMPLETED_TASK_QUERY.data(), -1, &insert_stmt_raw, nullptr);
-        if (rc != SQLITE_OK) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Failed to prepare insert statement: {}", sqlite3_errmsg(db.get())));
-        }
-        StatementPtr insert_stmt(insert_stmt_raw);
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error marking task complete: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in markTaskComplete: {}", e.what());
+      return false;
+    }
+  }
 
-        sqlite3_stmt* delete_stmt_raw = nullptr;
-        rc = sqlite3_prepare_v2(db.get(), Queries::DELETE_TASK_QUERY.data(), -1, &delete_stmt_raw, nullptr);
-        if (rc != SQLITE_OK) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Failed to prepare delete statement: {}", sqlite3_errmsg(db.get())));
-        }
-        StatementPtr delete_stmt(delete_stmt_raw);
-
-        bool anyMoved = false;
-        while ((rc = sqlite3_step(select_stmt.get())) == SQLITE_ROW) {
-          anyMoved = true;
-          int id = sqlite3_column_int(select_stmt.get(), 0);
-          const char* task_text_c = reinterpret_cast<const char*>(sqlite3_column_text(select_stmt.get(), 1));
-          std::string task_text = task_text_c ? task_text_c : "";
-
-          sqlite3_reset(insert_stmt.get());
-          sqlite3_clear_bindings(insert_stmt.get());
-          sqlite3_bind_text(insert_stmt.get(), 1, task_text.c_str(), -1, SQLITE_TRANSIENT);
-          if (sqlite3_step(insert_stmt.get()) != SQLITE_DONE) {
-            sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-            throw DatabaseException("Failed to insert into completed table during pattern operation.");
+  bool listAllCompletedCommands(Database& db, const ParsedCommand& pc) {
+     try {
+      const ListOptions options = parseListOptions(pc.description);
+      const DateRange& range = options.range;
+
+      bool tasks_found = false;
+      std::println("--- Task List ---");
+      std::println("    completed at    |                       Task");
+      std::println("--------------------|-------------------------------------------------------");
+
+      if (options.paged()) {
+        tasks_found = printPage(db, ListView::Completed, options);
+      } else if (!range.requested) {
+        // Only the hot database; archived history is read when a date range asks for it.
+        auto stmt = db.prepare(Queries::SELECT_COMPLETED_TASK_QUERY);
+        tasks_found = printCompletedRows(db, stmt);
+      } else {
+        // Walks the range newest first. Each archived year is merged with the
+        // main database's tasks from that year; the stretches between archived
+        // years only live in the main database.
+        auto printMain = [&](sqlite3_int64 from, sqlite3_int64 to) {
+          auto stmt = db.prepare(Queries::SELECT_COMPLETED_RANGE_QUERY);
+          sqlite3_bind_int64(stmt.get(), 1, from);
+          sqlite3_bind_int64(stmt.get(), 2, to);
+          tasks_found = printCompletedRows(db, stmt) || tasks_found;
+        };
+
+        const int firstYear = utcYear(range.from);
+        const int lastYear = utcYear(std::min<sqlite3_int64>(range.to, std::time(nullptr)));
+        sqlite3_int64 upper = range.to;
+        for (int year : archivedYears()) {
+          if (year < firstYear || year > lastYear) {
+            continue;
           }
 
-          sqlite3_reset(delete_stmt.get());
-          sqlite3_clear_bindings(delete_stmt.get());
-          sqlite3_bind_int(delete_stmt.get(), 1, id);
-          if (sqlite3_step(delete_stmt.get()) != SQLITE_DONE) {
-            sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-            throw DatabaseException("Failed to delete from tasks table during pattern operation.");
+          const sqlite3_int64 yearStart = std::max(utcYearStart(year), range.from);
+          const sqlite3_int64 yearEnd = std::min(utcYearStart(year + 1) - 1, upper);
+          printMain(yearEnd + 1, upper);
+
+          AttachedArchive archive(db, Paths::archivePath(year));
+          auto stmt = db.prepare(Queries::SELECT_MERGED_RANGE_QUERY);
+          sqlite3_bind_int64(stmt.get(), 1, yearStart);
+          sqlite3_bind_int64(stmt.get(), 2, yearEnd);
+          tasks_found = printCompletedRows(db, stmt) || tasks_found;
+          upper = yearStart - 1;
+        }
+        printMain(range.from, upper);
+      }
+
+      if (!tasks_found) {
+        std::println("No tasks found.");
+      }
+
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error listing tasks: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in listAllCommands: {}", e.what());
+      return false;
+    }
+  }
+
+  bool listAllBoth(Database& db) {
+    // Print pending first, then completed
+    bool okPending = listAllTasks(db, ParsedCommand{Flag::LIST_PENDING, ""});
+    std::println("");
+    std::println("--- Completed Tasks ---");
+    bool okCompleted = listAllCompletedCommands(db, ParsedCommand{Flag::SHOW_COMPLETE_TASKS, ""});
+    return okPending && okCompleted;
+  }
+
+  int countPendingTasks(Database& db) {
+    try {
+      auto store = openTaskStore(db);
+      return static_cast<int>(store->countPending());
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error counting pending tasks: {}", e.what());
+      return 0;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in countPendingTasks: {}", e.what());
+      return 0;
+    }
+  }
+
+  bool showSettings(Database& db) {
+    try {
+      const Settings& config = settings::current();
+      std::println("Config file: {} ({})", Paths::configPath().string(), config.configLoaded ? "loaded" : "not found");
+      std::println("Preset:      {}", config.preset.empty() ? "(none)" : config.preset);
+      std::println("Backend:     {}", settings::name(config.backend));
+      std::println("In memory:   {}", db.file() || sqlite3_db_filename(db.get(), "main")[0] == '\0' ? "on" : "off");
+      std::println("");
+      std::println("Effective settings for {}:", Paths::dbPath().string());
+
+      static constexpr std::string_view pragmas[] = {
+        "journal_mode", "synchronous", "cache_size", "mmap_size", "page_size", "temp_store", "auto_vacuum",
+        "freelist_count",
+      };
+      for (std::string_view pragma : pragmas) {
+        std::println("  {:<15} {}", pragma, pragmaValue(db, pragma));
+      }
+
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error reading settings: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in showSettings: {}", e.what());
+      return false;
+    }
+  }
+
+  bool checkQueryPlans(Database& db) {
+    try {
+      bool allIndexed = true;
+
+      for (std::string_view query : Queries::INDEXED_QUERIES) {
+        auto stmt = db.prepare(std::format("EXPLAIN QUERY PLAN {}", query));
+
+        std::vector<std::string> problems;
+        int rc;
+        while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+          const char* detail_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 3));
+          std::string_view detail = detail_c ? detail_c : "";
+
+          // "SCAN t USING [COVERING] INDEX i" walks an index in order and is fine;
+          // a bare "SCAN t" reads the whole table.
+          bool tableScan = detail.starts_with("SCAN ") && detail.find(" USING ") == std::string_view::npos;
+          bool tempBTree = detail.find("USE TEMP B-TREE") != std::string_view::npos;
+          if (tableScan || tempBTree) {
+            problems.emplace_back(detail);
           }
         }
 
         if (rc != SQLITE_DONE) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Error iterating pattern results: {}", sqlite3_errmsg(db.get())));
+          throw DatabaseException(std::format("Error explaining query (code: {}): {}", rc, sqlite3_errmsg(db.get())));
         }
 
-        if (!anyMoved) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("No tasks matched pattern '{}'.", pattern));
+        std::println("{}  {}", problems.empty() ? "ok  " : "FAIL", query);
+        for (const auto& problem : problems) {
+          std::println("        {}", problem);
         }
+        allIndexed = allIndexed && problems.empty();
+      }
 
-        sqlite3_exec(db.get(), "COMMIT;", 0, 0, 0);
-        return true;
+      return allIndexed;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error checking query plans: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in checkQueryPlans: {}", e.what());
+      return false;
+    }
+  }
+
+  bool searchTasks(Database& db, const ParsedCommand& pc) {
+    try {
+      std::string query = ftsQuery(pc.description);
+      if (query.empty()) {
+        throw DatabaseException("Search query is empty.");
       }
 
-      // 1. Select the task from the tasks table by id
-      sqlite3_stmt* select_stmt_raw = nullptr;
-      int rc = sqlite3_prepare_v2(db.get(), Queries::SELECT_TASK_BY_ID_QUERY.data(), -1, &select_stmt_raw, nullptr);
-      if (rc != SQLITE_OK) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Failed to prepare select statement: {}", sqlite3_errmsg(db.get())));
+      const bool terminal = isatty(fileno(stdout));
+      const char* open = terminal ? "\033[1m" : "[";
+      const char* close = terminal ? "\033[0m" : "]";
+
+      auto stmt = db.prepare(Queries::SEARCH_TASKS_QUERY);
+      sqlite3_bind_text(stmt.get(), 1, query.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_text(stmt.get(), 2, open, -1, SQLITE_STATIC);
+      sqlite3_bind_text(stmt.get(), 3, close, -1, SQLITE_STATIC);
+      sqlite3_bind_int(stmt.get(), 4, SEARCH_RESULT_LIMIT);
+
+      bool tasks_found = false;
+      std::println(" ID | State   | Task");
+      std::println("----|---------|---------------------------------------------");
+
+      int rc;
+      while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+        tasks_found = true;
+        std::string_view state = statusName(sqlite3_column_int(stmt.get(), 0));
+        int id = sqlite3_column_int(stmt.get(), 1);
+        const char* snippet = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 2));
+
+        std::println("{:<3} | {:<7} | {}", id, state, snippet ? snippet : "(No Description)");
       }
-      StatementPtr select_stmt(select_stmt_raw);
-      sqlite3_bind_int(select_stmt.get(), 1, task_id);
 
-      std::string task_text;
-      if (sqlite3_step(select_stmt.get()) == SQLITE_ROW) {
-          const char* txt = reinterpret_cast<const char*>(sqlite3_column_text(select_stmt.get(), 0));
-          task_text = txt ? txt : "";
-      } else {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Task with ID {} not found.", task_id));
+      if (rc != SQLITE_DONE) {
+        throw DatabaseException(std::format("Error stepping through results (code: {}): {}", rc, sqlite3_errmsg(db.get())));
       }
 
-      // Insert into completed table
-      sqlite3_stmt* insert_stmt_raw = nullptr;
-      rc = sqlite3_prepare_v2(db.get(), Queries::INSERT_COMPLETED_TASK_QUERY.data(), -1, &insert_stmt_raw, nullptr);
-      if (rc != SQLITE_OK) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Failed to prepare insert statement: {}", sqlite3_errmsg(db.get())));
+      if (!tasks_found) {
+        std::println("No tasks matched '{}'.", pc.description);
       }
-      StatementPtr insert_stmt(insert_stmt_raw);
-      sqlite3_bind_text(insert_stmt.get(), 1, task_text.c_str(), -1, SQLITE_TRANSIENT);
-      if (sqlite3_step(insert_stmt.get()) != SQLITE_DONE) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException("Failed to insert into completed table.");
+
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error searching tasks: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in searchTasks: {}", e.what());
+      return false;
+    }
+  }
+
+  bool verifyCounters(Database& db) {
+    try {
+      static constexpr std::string_view names[] = {"pending", "total", "completed_today"};
+
+      Transaction transaction(db, Queries::BEGIN_IMMEDIATE_QUERY);
+      auto stored = db.prepare(Queries::SELECT_COUNTERS_QUERY);
+      auto actual = db.prepare(Queries::COUNT_TASKS_QUERY);
+      if (sqlite3_step(stored.get()) != SQLITE_ROW || sqlite3_step(actual.get()) != SQLITE_ROW) {
+        throw DatabaseException(std::format("Error reading counters: {}", sqlite3_errmsg(db.get())));
       }
 
-      // Delete from tasks
-      sqlite3_stmt* delete_stmt_raw = nullptr;
-      rc = sqlite3_prepare_v2(db.get(), Queries::DELETE_TASK_QUERY.data(), -1, &delete_stmt_raw, nullptr);
-      if (rc != SQLITE_OK) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException(std::format("Failed to prepare delete statement: {}", sqlite3_errmsg(db.get())));
+      int drifted = 0;
+      std::println("{:<16} {:>10} {:>10}", "counter", "stored", "actual");
+      for (int i = 0; i < static_cast<int>(std::size(names)); i++) {
+        const long long have = sqlite3_column_int64(stored.get(), i);
+        const long long want = sqlite3_column_int64(actual.get(), i);
+        std::println("{:<16} {:>10} {:>10}  {}", names[i], have, want, have == want ? "ok" : "fixed");
+        if (have == want) {
+          continue;
+        }
+
+        drifted++;
+        auto fix = db.prepare(Queries::SET_COUNTER_QUERY);
+        sqlite3_bind_text(fix.get(), 1, names[i].data(), static_cast<int>(names[i].size()), SQLITE_STATIC);
+        sqlite3_bind_int64(fix.get(), 2, want);
+        if (sqlite3_step(fix.get()) != SQLITE_DONE) {
+          throw DatabaseException(std::format("Error repairing counter {}: {}", names[i], sqlite3_errmsg(db.get())));
+        }
       }
-      StatementPtr delete_stmt(delete_stmt_raw);
-      sqlite3_bind_int(delete_stmt.get(), 1, task_id);
-      if (sqlite3_step(delete_stmt.get()) != SQLITE_DONE) {
-          sqlite3_exec(db.get(), "ROLLBACK;", 0, 0, 0);
-          throw DatabaseException("Failed to delete from tasks table.");
+      if (drifted > 0) {
+        // completed_today was recounted for today, so it now belongs to today.
+        execOrThrow(db, Queries::RESET_COMPLETED_DAY_QUERY);
       }
+      transaction.commit();
 
-      // Commit transaction
-      sqlite3_exec(db.get(), "COMMIT;", 0, 0, 0);
-
+      std::println("{}", drifted == 0 ? "All counters match." : std::format("Repaired {} counter(s).", drifted));
       return true;
-
     } catch (const DatabaseException& e) {
-      std::println(stderr, "DB Error marking task complete: {}", e.what());
+      std::println(stderr, "DB Error verifying counters: {}", e.what());
       return false;
     } catch (const std::exception& e) {
-      std::println(stderr, "General Error in markTaskComplete: {}", e.what());
+      std::println(stderr, "General Error in verifyCounters: {}", e.what());
       return false;
     }
   }
 
-  bool listAllCompletedCommands(const ParsedCommand& ) {
-     try {
-      auto db = openDatabase(); 
-      sqlite3_stmt* raw_stmt = nullptr;
+  bool archiveCompleted(Database& db, const ParsedCommand& pc) {
+    try {
+      std::string age = pc.description;
+      ltrim(age);
+      rtrim(age);
+      if (age.rfind("--older-than", 0) == 0) {
+        age.erase(0, 12);
+        ltrim(age);
+        if (!age.empty() && age.front() == '=') {
+          age.erase(0, 1);
+        }
+      }
+      const long long maxAge = age.empty() ? DEFAULT_ARCHIVE_AGE_SECONDS : ageSeconds(age);
+      const sqlite3_int64 cutoff = static_cast<sqlite3_int64>(std::time(nullptr)) - maxAge;
+
+      std::vector<int> years;
+      {
+        auto stmt = db.prepare(Queries::SELECT_ARCHIVABLE_YEARS_QUERY);
+        sqlite3_bind_int64(stmt.get(), 1, cutoff);
+        int rc;
+        while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+          years.push_back(sqlite3_column_int(stmt.get(), 0));
+        }
+        if (rc != SQLITE_DONE) {
+          throw DatabaseException(std::format("Error finding tasks to archive (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+        }
+      }
 
-      int rc = sqlite3_prepare_v2(db.get(), Queries::SELECT_COMPLETED_TASK_QUERY.data(), -1, &raw_stmt, nullptr);
-      if (rc != SQLITE_OK) {
-        throw DatabaseException(std::format("Error preparing LIST statement: {}", sqlite3_errmsg(db.get())));
+      if (years.empty()) {
+        std::println("Nothing to archive.");
+        return true;
       }
+      std::filesystem::create_directories(Paths::archiveDirectoryPath());
+
+      int total = 0;
+      for (int year : years) {
+        int moved = 0;
+        const sqlite3_int64 start = utcYearStart(year);
+        const sqlite3_int64 end = std::min(utcYearStart(year + 1), cutoff);
+        AttachedArchive archive(db, Paths::archivePath(year));
+
+        for (std::string_view query : Queries::ARCHIVE_SCHEMA) {
+          char* errMsg = nullptr;
+          if (sqlite3_exec(db.get(), query.data(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            std::string error_detail = std::format("Error creating archive for {}: {}", year,
+                                                   errMsg ? errMsg : sqlite3_errmsg(db.get()));
+            sqlite3_free(errMsg);
+            throw DatabaseException(error_detail);
+          }
+        }
 
-      StatementPtr stmt(raw_stmt); 
+        // Copy first and delete in a second transaction. A WAL database does not
+        // commit atomically across attached files, so a crash in between can only
+        // leave rows in both places; the next run overwrites the copies and deletes them.
+        for (std::string_view query : {Queries::COPY_TO_ARCHIVE_QUERY, Queries::DELETE_ARCHIVED_QUERY}) {
+          Transaction transaction(db, Queries::BEGIN_IMMEDIATE_QUERY);
+          auto stmt = db.prepare(query);
+          sqlite3_bind_int64(stmt.get(), 1, start);
+          sqlite3_bind_int64(stmt.get(), 2, end);
+          int rc = sqlite3_step(stmt.get());
+          if (rc != SQLITE_DONE) {
+            throw DatabaseException(std::format("Error archiving {} (code: {}): {}", year, rc, sqlite3_errmsg(db.get())));
+          }
+          moved = sqlite3_changes(db.get());
+          transaction.commit();
+        }
 
-      bool tasks_found = false;
-      std::println("--- Task List ---");
-      std::println("    completed at    |                       Task");
-      std::println("--------------------|-------------------------------------------------------");
+        total += moved;
+        std::println("{:>6} completed tasks -> {}", moved, Paths::archivePath(year).string());
+      }
 
-      while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
-        tasks_found = true;
-        const char* taskText = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 0));
-        const char* completedAt = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 1));
+      std::println("Archived {} completed tasks.", total);
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error archiving tasks: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in archiveCompleted: {}", e.what());
+      return false;
+    }
+  }
 
-        std::println("{} |      {}", completedAt, taskText ? taskText : "(No Description)");
+  bool maintain(Database& db, const ParsedCommand& pc) {
+    try {
+      auto budget = std::chrono::steady_clock::duration(DEFAULT_MAINTENANCE_BUDGET);
+      bool full = false;
+
+      std::istringstream in(pc.description);
+      std::string option;
+      while (in >> option) {
+        if (option == "--full") {
+          full = true;
+        } else if (option == "--budget") {
+          std::string value;
+          in >> value;
+          budget = std::chrono::milliseconds(positiveNumber(option, value));
+        } else {
+          throw DatabaseException(std::format("Unknown option '{}': expected --full or --budget <ms>.", option));
+        }
       }
 
-      if (rc != SQLITE_DONE) {
-        throw DatabaseException(std::format("Error stepping through results (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+      const auto started = std::chrono::steady_clock::now();
+      const AutoVacuum wanted = settings::current().autoVacuum;
+
+      if (full) {
+        // VACUUM rewrites the whole file, which is also the only way to change auto_vacuum on an existing database.
+        const long long pagesBefore = pragmaInt(db, "page_count");
+        execPragma(db.get(), std::format("PRAGMA auto_vacuum = {};", settings::name(wanted)));
+        execOrThrow(db, "VACUUM;");
+        std::println("vacuum:             {} -> {} pages, auto_vacuum = {} ({} ms)", pagesBefore,
+                     pragmaInt(db, "page_count"), settings::name(wanted), elapsedMs(started));
+      } else if (pragmaInt(db, "auto_vacuum") == 2) {
+        const long long reclaimed = incrementalVacuum(db, budget);
+        std::println("incremental vacuum: {} pages reclaimed, {} still free ({} ms)", reclaimed,
+                     pragmaInt(db, "freelist_count"), elapsedMs(started));
+      } else {
+        std::println("incremental vacuum: skipped, auto_vacuum is not INCREMENTAL; {} free pages "
+                     "(run `nudge maintain --full` to convert)", pragmaInt(db, "freelist_count"));
       }
 
-      if (!tasks_found) {
-        std::println("No tasks found.");
-      }
+      auto step = std::chrono::steady_clock::now();
+      execPragma(db.get(), std::format("PRAGMA analysis_limit = {};", ANALYSIS_LIMIT));
+      execOrThrow(db, "ANALYZE;");
+      std::println("analyze:            {} ms", elapsedMs(step));
 
+      step = std::chrono::steady_clock::now();
+      execOrThrow(db, "PRAGMA optimize;");
+      std::println("optimize:           {} ms", elapsedMs(step));
+
+      execOrThrow(db, Queries::RESET_WRITES_QUERY);
+      std::println("total:              {} ms", elapsedMs(started));
       return true;
     } catch (const DatabaseException& e) {
-      std::println(stderr, "DB Error listing tasks: {}", e.what());
+      std::println(stderr, "DB Error during maintenance: {}", e.what());
       return false;
     } catch (const std::exception& e) {
-      std::println(stderr, "General Error in listAllCommands: {}", e.what());
+      std::println(stderr, "General Error in maintain: {}", e.what());
       return false;
     }
   }
 
-  bool listAllBoth() {
-    // Print pending first, then completed
-    bool okPending = listAllTasks();
-    std::println("");
-    std::println("--- Completed Tasks ---");
-    bool okCompleted = listAllCompletedCommands(ParsedCommand{Flag::SHOW_COMPLETE_TASKS, ""});
-    return okPending && okCompleted;
+  long long totalWrites(Database& db) {
+    return sqlite3_total_changes64(db.get());
   }
 
-  int countPendingTasks() {
+  void maintainIfDue(Database& db) {
+    if (db.access() != Access::ReadWrite) {
+      return;
+    }
+
     try {
-      auto db = openDatabase();
-      sqlite3_stmt* raw_stmt = nullptr;
-      const char* query = "SELECT COUNT(*) FROM tasks WHERE status = 'pending';";
-      int rc = sqlite3_prepare_v2(db.get(), query, -1, &raw_stmt, nullptr);
-      if (rc != SQLITE_OK) {
-        throw DatabaseException(std::format("Failed to prepare count statement: {}", sqlite3_errmsg(db.get())));
+      long long pending = 0;
+      {
+        auto stmt = db.prepare(Queries::SELECT_WRITES_QUERY);
+        if (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+          pending = sqlite3_column_int64(stmt.get(), 0);
+        }
       }
-      StatementPtr stmt(raw_stmt);
-      rc = sqlite3_step(stmt.get());
-      if (rc == SQLITE_ROW) {
-        int cnt = sqlite3_column_int(stmt.get(), 0);
-        return cnt;
+      if (pending < MAINTENANCE_WRITE_THRESHOLD) {
+        return;
       }
-      return 0;
-    } catch (const DatabaseException& e) {
-      std::println(stderr, "DB Error counting pending tasks: {}", e.what());
-      return 0;
+
+      if (pragmaInt(db, "auto_vacuum") == 2) {
+        incrementalVacuum(db, MAINTENANCE_SLICE);
+      }
+      execPragma(db.get(), std::format("PRAGMA analysis_limit = {};", ANALYSIS_LIMIT));
+      execOrThrow(db, "PRAGMA optimize;");
+      execOrThrow(db, Queries::RESET_WRITES_QUERY);
     } catch (const std::exception& e) {
-      std::println(stderr, "General Error in countPendingTasks: {}", e.what());
-      return 0;
+      // Upkeep is best effort; the command itself already succeeded or failed.
+      std::println(stderr, "Warning: skipped background maintenance: {}", e.what());
     }
   }
 } // Database
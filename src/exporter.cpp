@@ -0,0 +1,294 @@
+#include <print>
+#include <format>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "sqlite3.h"
+#include "paths.hpp"
+#include "flags.hpp"
+#include "database.hpp"
+#include "exporter.hpp"
+
+namespace {
+  constexpr std::size_t OUTPUT_BUFFER_BYTES = 1 << 20;
+
+  enum class Format {
+    Csv,
+    Jsonl,
+  };
+
+  enum class Selection {
+    Pending,
+    Completed,
+    All,
+  };
+
+  struct Options {
+    Format format = Format::Csv;
+    Selection selection = Selection::All;
+  };
+
+  Options parseOptions(const std::string& description) {
+    Options options;
+    std::istringstream in(description);
+    std::string word;
+    while (in >> word) {
+      std::string value;
+      std::string option = word;
+      if (auto eq = word.find('='); eq != std::string::npos) {
+        value = word.substr(eq + 1);
+        option = word.substr(0, eq);
+      } else if (word == "--format") {
+        in >> value;
+      }
+
+      if (option == "--format") {
+        lower(value);
+        if (value == "csv") options.format = Format::Csv;
+        else if (value == "jsonl" || value == "ndjson") options.format = Format::Jsonl;
+        else throw DatabaseException(std::format("Unknown export format '{}': expected csv or jsonl.", value));
+      } else if (option == "--pending") {
+        options.selection = Selection::Pending;
+      } else if (option == "--completed") {
+        options.selection = Selection::Completed;
+      } else if (option == "--all") {
+        options.selection = Selection::All;
+      } else {
+        throw DatabaseException(std::format("Unknown export option '{}'.", word));
+      }
+    }
+    return options;
+  }
+
+  // A fixed block of memory that rows are formatted into and that goes out in
+  // one write() whenever it fills up.
+  class OutputBuffer {
+    public:
+      explicit OutputBuffer(int fd) : fd(fd), data(std::make_unique<char[]>(OUTPUT_BUFFER_BYTES)) {}
+
+      void append(const char* text, std::size_t size) {
+        if (size > OUTPUT_BUFFER_BYTES - used) {
+          flush();
+          if (size > OUTPUT_BUFFER_BYTES) {
+            writeAll(text, size);
+            return;
+          }
+        }
+        std::memcpy(data.get() + used, text, size);
+        used += size;
+      }
+
+      void append(std::string_view text) { append(text.data(), text.size()); }
+
+      void put(char c) {
+        if (used == OUTPUT_BUFFER_BYTES) {
+          flush();
+        }
+        data[used++] = c;
+      }
+
+      void appendInt(sqlite3_int64 value) {
+        if (OUTPUT_BUFFER_BYTES - used < 24) {
+          flush();
+        }
+        used = static_cast<std::size_t>(std::to_chars(data.get() + used, data.get() + OUTPUT_BUFFER_BYTES, value).ptr - data.get());
+      }
+
+      void flush() {
+        writeAll(data.get(), used);
+        used = 0;
+      }
+
+      std::size_t bytesWritten() const { return written + used; }
+
+    private:
+      void writeAll(const char* bytes, std::size_t size) {
+        while (size > 0) {
+          ssize_t n = write(fd, bytes, size);
+          if (n < 0 && errno == EINTR) {
+            continue;
+          }
+          if (n <= 0) {
+            throw std::runtime_error(std::format("write failed: {}", std::strerror(errno)));
+          }
+          bytes += n;
+          size -= static_cast<std::size_t>(n);
+          written += static_cast<std::size_t>(n);
+        }
+      }
+
+      int fd;
+      std::unique_ptr<char[]> data;
+      std::size_t used = 0;
+      std::size_t written = 0;
+  };
+
+  // RFC 4180: quote only fields that need it, doubling embedded quotes.
+  void appendCsvField(OutputBuffer& out, const char* text, std::size_t size) {
+    const char* end = text + size;
+    const char* special = std::find_if(text, end, [](char c) { return c == ',' || c == '"' || c == '\n' || c == '\r'; });
+    if (special == end) {
+      out.append(text, size);
+      return;
+    }
+
+    out.put('"');
+    const char* start = text;
+    for (const char* p = special; p != end; p++) {
+      if (*p == '"') {
+        out.append(start, static_cast<std::size_t>(p - start + 1));
+        out.put('"');
+        start = p + 1;
+      }
+    }
+    out.append(start, static_cast<std::size_t>(end - start));
+    out.put('"');
+  }
+
+  // Copies runs of plain bytes in one go; UTF-8 passes through unchanged.
+  void appendJsonString(OutputBuffer& out, const char* text, std::size_t size) {
+    static constexpr char hex[] = "0123456789abcdef";
+    out.put('"');
+    const char* start = text;
+    const char* end = text + size;
+    for (const char* p = text; p != end; p++) {
+      const auto c = static_cast<unsigned char>(*p);
+      if (c >= 0x20 && c != '"' && c != '\\') {
+        continue;
+      }
+
+      out.append(start, static_cast<std::size_t>(p - start));
+      start = p + 1;
+      switch (c) {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        default: {
+          const char escape[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+          out.append(escape, sizeof(escape));
+        }
+      }
+    }
+    out.append(start, static_cast<std::size_t>(end - start));
+    out.put('"');
+  }
+
+  std::string_view statusText(int status) {
+    return static_cast<TaskStatus>(status) == TaskStatus::Completed ? "done" : "pending";
+  }
+
+  // Rows are (id, task, status, created_at, completed_at).
+  long long streamRows(Database& db, StatementCache::Lease& stmt, OutputBuffer& out, Format format) {
+    long long rows = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+      rows++;
+      const sqlite3_int64 id = sqlite3_column_int64(stmt.get(), 0);
+      const char* task = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 1));
+      const auto taskBytes = static_cast<std::size_t>(sqlite3_column_bytes(stmt.get(), 1));
+      const std::string_view status = statusText(sqlite3_column_int(stmt.get(), 2));
+      const sqlite3_int64 createdAt = sqlite3_column_int64(stmt.get(), 3);
+      const bool hasCompletedAt = sqlite3_column_type(stmt.get(), 4) != SQLITE_NULL;
+
+      if (format == Format::Csv) {
+        out.appendInt(id);
+        out.put(',');
+        appendCsvField(out, task ? task : "", taskBytes);
+        out.put(',');
+        out.append(status);
+        out.put(',');
+        out.appendInt(createdAt);
+        out.put(',');
+        if (hasCompletedAt) {
+          out.appendInt(sqlite3_column_int64(stmt.get(), 4));
+        }
+      } else {
+        out.append("{\"id\":");
+        out.appendInt(id);
+        out.append(",\"task\":");
+        appendJsonString(out, task ? task : "", taskBytes);
+        out.append(",\"status\":\"");
+        out.append(status);
+        out.append("\",\"created_at\":");
+        out.appendInt(createdAt);
+        out.append(",\"completed_at\":");
+        if (hasCompletedAt) {
+          out.appendInt(sqlite3_column_int64(stmt.get(), 4));
+        } else {
+          out.append("null");
+        }
+        out.put('}');
+      }
+      out.put('\n');
+    }
+
+    if (rc != SQLITE_DONE) {
+      throw DatabaseException(std::format("Error stepping through results (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+    }
+    return rows;
+  }
+} // private namespace
+
+namespace exporter {
+  bool exportTasks(Database& db, const ParsedCommand& pc) {
+    try {
+      const Options options = parseOptions(pc.description);
+      const auto started = std::chrono::steady_clock::now();
+
+      // Anything already printed through stdio must come out before the raw writes.
+      std::fflush(stdout);
+      OutputBuffer out(STDOUT_FILENO);
+      if (options.format == Format::Csv) {
+        out.append("id,task,status,created_at,completed_at\n");
+      }
+
+      long long rows = 0;
+      if (options.selection != Selection::Pending) {
+        // Oldest partitions first, so the output runs roughly in id order.
+        std::vector<int> years = database::archivedYears();
+        for (auto it = years.rbegin(); it != years.rend(); ++it) {
+          AttachedArchive archive(db, Paths::archivePath(*it));
+          auto stmt = db.prepare(Queries::EXPORT_ARCHIVED_QUERY);
+          rows += streamRows(db, stmt, out, options.format);
+        }
+      }
+
+      if (options.selection == Selection::All) {
+        auto stmt = db.prepare(Queries::EXPORT_TASKS_QUERY);
+        rows += streamRows(db, stmt, out, options.format);
+      } else {
+        auto stmt = db.prepare(Queries::EXPORT_TASKS_BY_STATUS_QUERY);
+        const TaskStatus status = options.selection == Selection::Pending ? TaskStatus::Pending : TaskStatus::Completed;
+        sqlite3_bind_int(stmt.get(), 1, static_cast<int>(status));
+        rows += streamRows(db, stmt, out, options.format);
+      }
+      out.flush();
+
+      // stdout carries the data, so the summary goes to stderr.
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+      std::println(stderr, "Exported {} tasks ({:.1f} MiB) in {:.2f} s.", rows,
+                   static_cast<double>(out.bytesWritten()) / (1 << 20), seconds);
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error exporting tasks: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in exportTasks: {}", e.what());
+      return false;
+    }
+  }
+} // exporter
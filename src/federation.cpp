@@ -0,0 +1,473 @@
+#include <print>
+#include <format>
+#include <string>
+#include <vector>
+#include <queue>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+#include <utility>
+
+#include <unistd.h>
+
+#include "sqlite3.h"
+#include "paths.hpp"
+#include "flags.hpp"
+#include "database.hpp"
+#include "federation.hpp"
+
+namespace {
+  constexpr std::string_view LOCAL_STORE = "local";
+  constexpr int SEARCH_RESULT_LIMIT = 50;
+  // Schema version 6 merged completed tasks into `tasks`, which every query here reads.
+  constexpr int MIN_STORE_SCHEMA_VERSION = 6;
+
+  struct Store {
+    std::string name;
+    std::filesystem::path path;
+  };
+
+  std::string trim(std::string_view text) {
+    const auto first = text.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) {
+      return "";
+    }
+    const auto last = text.find_last_not_of(" \t\r");
+    return std::string(text.substr(first, last - first + 1));
+  }
+
+  // The registered stores, in registry order. A missing registry is an empty one.
+  std::vector<Store> readRegistry() {
+    std::vector<Store> stores;
+    std::ifstream file(Paths::storesPath());
+    std::string line;
+    while (std::getline(file, line)) {
+      if (trim(line).empty() || trim(line).starts_with('#')) {
+        continue;
+      }
+      const auto eq = line.find('=');
+      if (eq == std::string::npos) {
+        std::println(stderr, "{}: ignoring malformed line '{}'.", Paths::storesPath().string(), line);
+        continue;
+      }
+      stores.push_back({trim(std::string_view(line).substr(0, eq)), trim(std::string_view(line).substr(eq + 1))});
+    }
+    return stores;
+  }
+
+  // Rewrites the registry through a temporary file, so a crash leaves the old one.
+  void writeRegistry(const std::vector<Store>& stores) {
+    const std::filesystem::path partial = Paths::storesPath().string() + ".partial";
+    {
+      std::ofstream file(partial, std::ios::trunc);
+      file << "# Task databases read by `nudge all`; managed with `nudge store`.\n";
+      for (const Store& store : stores) {
+        file << std::format("{} = {}\n", store.name, store.path.string());
+      }
+      if (!file.flush()) {
+        throw DatabaseException(std::format("Cannot write {}.", partial.string()));
+      }
+    }
+    std::filesystem::rename(partial, Paths::storesPath());
+  }
+
+  bool validName(std::string_view name) {
+    return !name.empty() && name != LOCAL_STORE && std::all_of(name.begin(), name.end(), [](unsigned char c) {
+      return std::isalnum(c) || c == '-' || c == '_';
+    });
+  }
+
+  void addStore(const std::vector<std::string>& args) {
+    if (args.size() != 3) {
+      throw DatabaseException("Usage: nudge store add <name> <path>");
+    }
+    const std::string& name = args[1];
+    if (!validName(name)) {
+      throw DatabaseException(std::format("Invalid store name '{}': use letters, digits, '-' or '_' (not '{}').",
+                                          name, LOCAL_STORE));
+    }
+
+    std::error_code ec;
+    const std::filesystem::path path = std::filesystem::canonical(args[2], ec);
+    if (ec || !std::filesystem::is_regular_file(path)) {
+      throw DatabaseException(std::format("No database file at '{}'.", args[2]));
+    }
+    if (std::filesystem::equivalent(path, Paths::dbPath(), ec)) {
+      throw DatabaseException(std::format("'{}' is the local database, which is always included.", args[2]));
+    }
+
+    std::vector<Store> stores = readRegistry();
+    for (const Store& store : stores) {
+      if (store.name == name) {
+        throw DatabaseException(std::format("A store named '{}' already exists.", name));
+      }
+      if (std::filesystem::equivalent(store.path, path, ec)) {
+        throw DatabaseException(std::format("'{}' is already registered as '{}'.", path.string(), store.name));
+      }
+    }
+
+    stores.push_back({name, path});
+    writeRegistry(stores);
+    std::println("Added store '{}' ({}).", name, path.string());
+  }
+
+  void removeStore(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+      throw DatabaseException("Usage: nudge store remove <name>");
+    }
+    std::vector<Store> stores = readRegistry();
+    const auto erased = std::erase_if(stores, [&](const Store& store) { return store.name == args[1]; });
+    if (erased == 0) {
+      throw DatabaseException(std::format("No store named '{}'.", args[1]));
+    }
+    writeRegistry(stores);
+    std::println("Removed store '{}'. Its database file was left in place.", args[1]);
+  }
+
+  void listStores() {
+    std::println("{:<16} | Path", "Store");
+    std::println("-----------------|---------------------------------------------");
+    std::println("{:<16} | {}", LOCAL_STORE, Paths::dbPath().string());
+    for (const Store& store : readRegistry()) {
+      std::println("{:<16} | {}", store.name, store.path.string());
+    }
+  }
+
+  // A store taking part in one federated command: the local database as `main`,
+  // registered ones attached as store1, store2, ...
+  struct Member {
+    std::string name;
+    std::string schema;
+    int version = 0;
+  };
+
+  // One registered store attached as `schema` until the object goes away.
+  class AttachedStore {
+    public:
+      AttachedStore(Database& db, const Store& store, std::string schema) : db(&db), schema(std::move(schema)) {
+        auto attach = db.prepare(std::format(Queries::ATTACH_STORE_QUERY, this->schema));
+        sqlite3_bind_text(attach.get(), 1, store.path.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(attach.get()) != SQLITE_DONE) {
+          throw DatabaseException(std::format("Failed to attach store '{}' ({}): {}", store.name,
+                                              store.path.string(), sqlite3_errmsg(db.get())));
+        }
+      }
+
+      ~AttachedStore() {
+        if (db) {
+          sqlite3_exec(db->get(), std::format(Queries::DETACH_STORE_QUERY, schema).c_str(), nullptr, nullptr, nullptr);
+        }
+      }
+
+      AttachedStore(AttachedStore&& other) noexcept : db(std::exchange(other.db, nullptr)), schema(std::move(other.schema)) {}
+      AttachedStore(const AttachedStore&) = delete;
+      AttachedStore& operator=(const AttachedStore&) = delete;
+      AttachedStore& operator=(AttachedStore&&) = delete;
+
+    private:
+      Database* db;
+      std::string schema;
+  };
+
+  // Attaches every registered store for the lifetime of the object. Statements
+  // that read them must be finished before it goes out of scope. If one store
+  // fails to attach or is too old, those already attached are detached again
+  // as the constructor throws.
+  class Federation {
+    public:
+      explicit Federation(Database& db) {
+        members.push_back({std::string(LOCAL_STORE), "main", Queries::SCHEMA_VERSION});
+
+        const std::vector<Store> stores = readRegistry();
+        const int limit = sqlite3_limit(db.get(), SQLITE_LIMIT_ATTACHED, -1);
+        if (static_cast<int>(stores.size()) > limit) {
+          throw DatabaseException(std::format("{} stores are registered, but SQLite can attach at most {} at once.",
+                                              stores.size(), limit));
+        }
+
+        attached.reserve(stores.size());
+        for (const Store& store : stores) {
+          Member member{store.name, std::format("store{}", members.size()), 0};
+          attached.emplace_back(db, store, member.schema);
+
+          auto version = db.prepare(std::format(Queries::STORE_SCHEMA_VERSION_QUERY, member.schema));
+          member.version = sqlite3_step(version.get()) == SQLITE_ROW ? sqlite3_column_int(version.get(), 0) : 0;
+          if (member.version < MIN_STORE_SCHEMA_VERSION) {
+            throw DatabaseException(std::format("Store '{}' has schema version {}; version {} or newer is needed.",
+                                                store.name, member.version, MIN_STORE_SCHEMA_VERSION));
+          }
+          members.push_back(std::move(member));
+        }
+      }
+
+      Federation(const Federation&) = delete;
+      Federation& operator=(const Federation&) = delete;
+
+      std::vector<Member> members;
+
+    private:
+      std::vector<AttachedStore> attached;
+  };
+
+  // One row of a per-store stream. Streams hand out rows in ascending
+  // (primary, secondary) order; the merge keeps that order across stores.
+  struct Row {
+    double primary = 0;
+    long long secondary = 0;
+    long long id = 0;
+    int status = 0;
+    long long time = 0;
+    std::string text;
+  };
+
+  using RowReader = std::function<Row(sqlite3_stmt*)>;
+
+  struct Stream {
+    std::size_t member;
+    StatementCache::Lease stmt;
+    Row row;
+  };
+
+  bool advance(Database& db, Stream& stream, const RowReader& read) {
+    const int rc = sqlite3_step(stream.stmt.get());
+    if (rc == SQLITE_ROW) {
+      stream.row = read(stream.stmt.get());
+      return true;
+    }
+    if (rc != SQLITE_DONE) {
+      throw DatabaseException(std::format("Error stepping through results (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+    }
+    return false;
+  }
+
+  // k-way merge: only the current row of each stream is held, in a heap ordered
+  // by (primary, secondary, store). Emits at most `limit` rows (-1: all) and
+  // returns how many it emitted.
+  long long merge(Database& db, std::vector<Stream>& streams, const std::vector<Member>& members,
+                  const RowReader& read, long long limit, const std::function<void(const Member&, const Row&)>& emit) {
+    auto after = [&](std::size_t a, std::size_t b) {
+      const Row& x = streams[a].row;
+      const Row& y = streams[b].row;
+      if (x.primary != y.primary) return x.primary > y.primary;
+      if (x.secondary != y.secondary) return x.secondary > y.secondary;
+      return streams[a].member > streams[b].member;
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(after)> heads(after);
+
+    for (std::size_t i = 0; i < streams.size(); i++) {
+      if (advance(db, streams[i], read)) {
+        heads.push(i);
+      }
+    }
+
+    long long emitted = 0;
+    while (!heads.empty() && (limit < 0 || emitted < limit)) {
+      const std::size_t i = heads.top();
+      heads.pop();
+      emit(members[streams[i].member], streams[i].row);
+      emitted++;
+      if (advance(db, streams[i], read)) {
+        heads.push(i);
+      }
+    }
+    return emitted;
+  }
+
+  long long parseLimit(const std::vector<std::string>& args, std::size_t from) {
+    long long limit = -1;
+    for (std::size_t i = from; i < args.size(); i++) {
+      std::string value;
+      if (args[i].starts_with("--limit=")) {
+        value = args[i].substr(8);
+      } else if (args[i] == "--limit" && i + 1 < args.size()) {
+        value = args[++i];
+      } else {
+        throw DatabaseException(std::format("Unknown option '{}': expected --limit N.", args[i]));
+      }
+      auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), limit);
+      if (ec != std::errc() || end != value.data() + value.size() || limit < 1) {
+        throw DatabaseException(std::format("Invalid --limit '{}': expected a positive number.", value));
+      }
+    }
+    return limit;
+  }
+
+  // Newest first across stores: each store walks tasks_pending_idx or
+  // tasks_completed_idx, so the heap orders by the negated time and id.
+  void listAll(Database& db, const Federation& federation, bool completed, long long limit) {
+    std::vector<Stream> streams;
+    streams.reserve(federation.members.size());
+    for (std::size_t i = 0; i < federation.members.size(); i++) {
+      const std::string_view query = completed ? Queries::STORE_COMPLETED_QUERY : Queries::STORE_PENDING_QUERY;
+      auto stmt = db.prepare(std::vformat(query, std::make_format_args(federation.members[i].schema)));
+      sqlite3_bind_int64(stmt.get(), 1, limit);
+      streams.push_back({i, std::move(stmt), {}});
+    }
+
+    const RowReader read = [](sqlite3_stmt* stmt) {
+      Row row;
+      row.id = sqlite3_column_int64(stmt, 0);
+      const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+      row.text = text && *text ? text : "(No Description)";
+      row.time = sqlite3_column_int64(stmt, 2);
+      row.primary = -static_cast<double>(row.time);
+      row.secondary = -row.id;
+      return row;
+    };
+
+    if (completed) {
+      std::println("    completed at    | Store            | Task");
+      std::println("--------------------|------------------|-------------------------------------");
+    } else {
+      std::println("Store            | ID    | Task");
+      std::println("-----------------|-------|---------------------------------------------");
+    }
+    const long long shown = merge(db, streams, federation.members, read, limit, [&](const Member& member, const Row& row) {
+      if (completed) {
+        std::println("{} | {:<16} | {}", database::formatLocalTime(row.time), member.name, row.text);
+      } else {
+        std::println("{:<16} | {:<5} | {}", member.name, row.id, row.text);
+      }
+    });
+
+    if (shown == 0) {
+      std::println("No tasks found.");
+    }
+  }
+
+  void countAll(Database& db, const Federation& federation) {
+    long long pending = 0;
+    long long total = 0;
+    std::println("{:<16} {:>10} {:>10}", "store", "pending", "total");
+    for (const Member& member : federation.members) {
+      const std::string_view query = member.version >= 8 ? Queries::STORE_COUNTERS_QUERY : Queries::STORE_COUNT_TASKS_QUERY;
+      auto stmt = db.prepare(std::vformat(query, std::make_format_args(member.schema)));
+      if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+        throw DatabaseException(std::format("Error counting tasks in '{}': {}", member.name, sqlite3_errmsg(db.get())));
+      }
+      const long long storePending = sqlite3_column_int64(stmt.get(), 0);
+      const long long storeTotal = sqlite3_column_int64(stmt.get(), 1);
+      std::println("{:<16} {:>10} {:>10}", member.name, storePending, storeTotal);
+      pending += storePending;
+      total += storeTotal;
+    }
+    std::println("{:<16} {:>10} {:>10}", "all", pending, total);
+  }
+
+  // Best bm25 rank first. Ranks come from each store's own index, so they are
+  // comparable only roughly; good enough to interleave the best matches.
+  void searchAll(Database& db, const Federation& federation, const std::string& text) {
+    const std::string query = database::ftsQuery(text);
+    if (query.empty()) {
+      throw DatabaseException("Search query is empty.");
+    }
+
+    const bool terminal = isatty(fileno(stdout));
+    const char* open = terminal ? "\033[1m" : "[";
+    const char* close = terminal ? "\033[0m" : "]";
+
+    std::vector<Stream> streams;
+    streams.reserve(federation.members.size());
+    for (std::size_t i = 0; i < federation.members.size(); i++) {
+      auto stmt = db.prepare(std::format(Queries::STORE_SEARCH_QUERY, federation.members[i].schema));
+      sqlite3_bind_text(stmt.get(), 1, query.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_text(stmt.get(), 2, open, -1, SQLITE_STATIC);
+      sqlite3_bind_text(stmt.get(), 3, close, -1, SQLITE_STATIC);
+      sqlite3_bind_int(stmt.get(), 4, SEARCH_RESULT_LIMIT);
+      streams.push_back({i, std::move(stmt), {}});
+    }
+
+    const RowReader read = [](sqlite3_stmt* stmt) {
+      Row row;
+      row.status = sqlite3_column_int(stmt, 0);
+      row.id = sqlite3_column_int64(stmt, 1);
+      const char* snippet = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+      row.text = snippet ? snippet : "(No Description)";
+      row.primary = sqlite3_column_double(stmt, 3);
+      row.secondary = row.id;
+      return row;
+    };
+
+    std::println("Store            | ID    | State   | Task");
+    std::println("-----------------|-------|---------|-----------------------------------");
+    const long long shown = merge(db, streams, federation.members, read, SEARCH_RESULT_LIMIT, [](const Member& member, const Row& row) {
+      const std::string_view state = static_cast<TaskStatus>(row.status) == TaskStatus::Completed ? "done" : "pending";
+      std::println("{:<16} | {:<5} | {:<7} | {}", member.name, row.id, state, row.text);
+    });
+
+    if (shown == 0) {
+      std::println("No tasks matched '{}'.", text);
+    }
+  }
+
+  std::vector<std::string> words(const std::string& text) {
+    std::vector<std::string> result;
+    std::istringstream in(text);
+    std::string word;
+    while (in >> word) {
+      result.push_back(word);
+    }
+    return result;
+  }
+} // private namespace
+
+namespace federation {
+  bool manageStores(Database&, const ParsedCommand& pc) {
+    try {
+      const std::vector<std::string> args = words(pc.description);
+      const std::string action = args.empty() ? "list" : args[0];
+      if (action == "add") {
+        addStore(args);
+      } else if (action == "remove") {
+        removeStore(args);
+      } else if (action == "list" && args.size() <= 1) {
+        listStores();
+      } else {
+        throw DatabaseException("Usage: nudge store add <name> <path> | remove <name> | list");
+      }
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error managing stores: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in manageStores: {}", e.what());
+      return false;
+    }
+  }
+
+  bool run(Database& db, const ParsedCommand& pc) {
+    try {
+      const std::vector<std::string> args = words(pc.description);
+      const std::string action = args.empty() ? "" : args[0];
+      if (action != "list" && action != "count" && action != "search") {
+        throw DatabaseException("Usage: nudge all list [-c] [--limit N] | count | search <query>");
+      }
+
+      Federation federation(db);
+      if (action == "list") {
+        const bool completed = args.size() > 1 && args[1] == "-c";
+        listAll(db, federation, completed, parseLimit(args, completed ? 2 : 1));
+      } else if (action == "count") {
+        if (args.size() > 1) {
+          throw DatabaseException("Usage: nudge all count");
+        }
+        countAll(db, federation);
+      } else {
+        const auto start = pc.description.find("search") + std::string_view("search").size();
+        searchAll(db, federation, trim(std::string_view(pc.description).substr(start)));
+      }
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error reading all stores: {}", e.what());
+      return false;
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in federation::run: {}", e.what());
+      return false;
+    }
+  }
+} // federation
@@ -8,6 +8,11 @@
 
 #include "flags.hpp"
 #include "database.hpp"
+#include "importer.hpp"
+#include "exporter.hpp"
+#include "backup.hpp"
+#include "federation.hpp"
+#include "settings.hpp"
 
 void lower(std::string& str) {
   std::transform(str.begin(), str.end(), str.begin(),
@@ -35,10 +40,10 @@ ParsedCommand parseCommand(int argc, char* argv[]) {
     if (cmd == "list") {
       if (argc >= 3) {
         std::string opt = argv[2];
-        if (opt == "-c") return {Flag::SHOW_COMPLETE_TASKS, ""};
+        if (opt == "-c") return {Flag::SHOW_COMPLETE_TASKS, joinArguments(argc, argv, 3)};
         if (opt == "-a") return {Flag::LIST_ALL, ""};
       }
-      return {Flag::LIST_PENDING, ""};
+      return {Flag::LIST_PENDING, joinArguments(argc, argv, 2)};
     }
 
     static const std::unordered_map<std::string, Flag> lookup = {
@@ -48,6 +53,19 @@ ParsedCommand parseCommand(int argc, char* argv[]) {
       {"comeplete", Flag::COMPLETE},
       {"notification", Flag::NOTIFY},
       {"notify", Flag::NOTIFY},
+      {"daemon", Flag::DAEMON},
+      {"config", Flag::SHOW_CONFIG},
+      {"check-plans", Flag::CHECK_PLANS},
+      {"search", Flag::SEARCH},
+      {"archive", Flag::ARCHIVE},
+      {"maintain", Flag::MAINTAIN},
+      {"import", Flag::IMPORT},
+      {"export", Flag::EXPORT},
+      {"backup", Flag::BACKUP},
+      {"restore", Flag::RESTORE},
+      {"verify-counters", Flag::VERIFY_COUNTERS},
+      {"store", Flag::STORE},
+      {"all", Flag::FEDERATED},
     };
 
     auto it = lookup.find(cmd);
@@ -59,54 +77,91 @@ ParsedCommand parseCommand(int argc, char* argv[]) {
     return {Flag::ERROR, ""};
 }
 
-void executeCommand(const ParsedCommand& pc) {
+namespace {
+  // Commands that read or write tasks directly in list.db rather than through a TaskStore.
+  bool needsSqliteBackend(Flag flag) {
+    switch (flag) {
+      case Flag::LIST_ALL:
+      case Flag::SHOW_COMPLETE_TASKS:
+      case Flag::SEARCH:
+      case Flag::ARCHIVE:
+      case Flag::IMPORT:
+      case Flag::EXPORT:
+      case Flag::BACKUP:
+      case Flag::RESTORE:
+      case Flag::FEDERATED:
+      case Flag::MAINTAIN:
+      case Flag::VERIFY_COUNTERS:
+      case Flag::CHECK_PLANS:
+        return true;
+      default:
+        return false;
+    }
+  }
+} // private namespace
+
+bool executeCommand(Database& db, const ParsedCommand& pc) {
+  if (settings::current().backend == Backend::Log && needsSqliteBackend(pc.flag)) {
+    std::println(stderr, "This command needs backend = sqlite; the log backend supports add, delete, complete, list and notify.");
+    return false;
+  }
+
+  bool ok = true;
+  const long long writesBefore = database::totalWrites(db);
+
   switch (pc.flag) {
     case Flag::SHOW_COMPLETE_TASKS:
       std::println("Completed tasks:");
-      if(!database::listAllCompletedCommands(pc)) {
+      if(!database::listAllCompletedCommands(db, pc)) {
         std::println(stderr, "Failed to list completed tasks");
+        ok = false;
       }
       break;
     case Flag::LIST_ALL:
       std::println("Listing all tasks (pending + completed):");
-      if (!database::listAllBoth()) {
+      if (!database::listAllBoth(db)) {
         std::println(stderr, "Failed to list all tasks.");
+        ok = false;
       }
       break;
     case Flag::LIST_PENDING:
       std::println("Pending tasks:");
-      if (!database::listAllTasks()) {
+      if (!database::listAllTasks(db, pc)) {
         std::println(stderr, "Failed to list pending tasks.");
+        ok = false;
       }
       break;
     case Flag::DEL:
-      if (database::deleteTask(pc)) {
+      if (database::deleteTask(db, pc)) {
         std::println("Successfully deleted task.");
       } else {
         std::println(stderr, "Deletion failed.");
+        ok = false;
       }
       break;
     case Flag::ADD:
-      if (database::addTask(pc)) {
+      if (database::addTask(db, pc)) {
         std::println("Task: \"{}\" was added.", pc.description);
       } else {
         std::println(stderr, "Failed to add task.");
+        ok = false;
       }
       break;
     case Flag::MARK_COMPLETE:
     case Flag::COMPLETE: {
-      if (database::markTaskComplete(pc)) {
+      if (database::markTaskComplete(db, pc)) {
         if (pc.description.empty()) {
           std::println("Marked first pending task as complete.");
         } else {
-          std::println("Task '{}' marked as complete.", pc.description);
+          std::println("Tasks listed above marked as complete.");
         }
       } else {
         std::println(stderr, "Failed to mark task as complete.");
+        ok = false;
       }
       } break;
     case Flag::NOTIFY: {
-      int pending = database::countPendingTasks();
+      int pending = database::countPendingTasks(db);
       std::string msg;
       if (pending <= 0) {
         msg = "All done for today ;)";
@@ -131,8 +186,92 @@ void executeCommand(const ParsedCommand& pc) {
       std::println("{}", msg);
 #endif
     } break;
+    case Flag::SHOW_CONFIG:
+      if (!database::showSettings(db)) {
+        std::println(stderr, "Failed to read settings.");
+        ok = false;
+      }
+      break;
+    case Flag::CHECK_PLANS:
+      if (!database::checkQueryPlans(db)) {
+        std::println(stderr, "Some queries are not served by an index.");
+        ok = false;
+      }
+      break;
+    case Flag::SEARCH:
+      if (!database::searchTasks(db, pc)) {
+        std::println(stderr, "Search failed.");
+        ok = false;
+      }
+      break;
+    case Flag::ARCHIVE:
+      if (!database::archiveCompleted(db, pc)) {
+        std::println(stderr, "Archiving failed.");
+        ok = false;
+      }
+      break;
+    case Flag::MAINTAIN:
+      if (!database::maintain(db, pc)) {
+        std::println(stderr, "Maintenance failed.");
+        ok = false;
+      }
+      break;
+    case Flag::IMPORT:
+      if (!importer::importTasks(db, pc)) {
+        std::println(stderr, "Import failed.");
+        ok = false;
+      }
+      break;
+    case Flag::EXPORT:
+      if (!exporter::exportTasks(db, pc)) {
+        std::println(stderr, "Export failed.");
+        ok = false;
+      }
+      break;
+    case Flag::BACKUP:
+      if (!backup::create(db, pc)) {
+        std::println(stderr, "Backup failed.");
+        ok = false;
+      }
+      break;
+    case Flag::RESTORE:
+      if (!backup::restore(db, pc)) {
+        std::println(stderr, "Restore failed.");
+        ok = false;
+      }
+      break;
+    case Flag::VERIFY_COUNTERS:
+      if (!database::verifyCounters(db)) {
+        std::println(stderr, "Counter verification failed.");
+        ok = false;
+      }
+      break;
+    case Flag::STORE:
+      if (!federation::manageStores(db, pc)) {
+        std::println(stderr, "Store command failed.");
+        ok = false;
+      }
+      break;
+    case Flag::FEDERATED:
+      if (!federation::run(db, pc)) {
+        std::println(stderr, "Failed to read all stores.");
+        ok = false;
+      }
+      break;
+    case Flag::DAEMON:
+      // Handled in main() before a session is opened; never dispatched here.
+      break;
     case Flag::ERROR:
       std::println(stderr, "Unknown command.");
+      ok = false;
       break;
   }
+
+  // Triggers already counted this command's writes; past the threshold, spend a
+  // short slice on upkeep. Commands that changed nothing skip even the check.
+  if (database::totalWrites(db) != writesBefore) {
+    database::maintainIfDue(db);
+  }
+
+  return ok;
 }
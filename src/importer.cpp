@@ -0,0 +1,742 @@
+#include <print>
+#include <format>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cctype>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <algorithm>
+#include <exception>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "sqlite3.h"
+#include "flags.hpp"
+#include "database.hpp"
+#include "importer.hpp"
+
+namespace {
+  constexpr long long DEFAULT_BATCH_ROWS = 10000;
+  // Rows handed from the parser to the writer at a time, and how many such
+  // chunks may be in flight; together they cap memory regardless of input size.
+  constexpr std::size_t CHUNK_ROWS = 512;
+  constexpr std::size_t QUEUE_CHUNKS = 8;
+  constexpr std::size_t READ_BUFFER_BYTES = 1 << 20;
+
+  enum class Format {
+    TodoTxt,
+    Csv,
+    Jsonl,
+  };
+
+  struct ImportedTask {
+    std::string task;
+    bool completed = false;
+    std::optional<long long> createdAt;
+    std::optional<long long> completedAt;
+  };
+
+  using Chunk = std::vector<ImportedTask>;
+
+  // A malformed record; it is reported and skipped.
+  class ImportError : public std::runtime_error {
+    public:
+      ImportError(const std::string& message) : std::runtime_error(message) {}
+  };
+
+  // Single-producer, single-consumer hand-off with a fixed capacity. The parser
+  // blocks when the writer falls behind; cancel() releases it if the writer fails.
+  class ChunkQueue {
+    public:
+      explicit ChunkQueue(std::size_t capacity) : capacity(capacity) {}
+
+      bool push(Chunk chunk) {
+        std::unique_lock lock(mutex);
+        notFull.wait(lock, [&] { return chunks.size() < capacity || cancelled; });
+        if (cancelled) {
+          return false;
+        }
+        chunks.push_back(std::move(chunk));
+        notEmpty.notify_one();
+        return true;
+      }
+
+      std::optional<Chunk> pop() {
+        std::unique_lock lock(mutex);
+        notEmpty.wait(lock, [&] { return !chunks.empty() || closed; });
+        if (chunks.empty()) {
+          return std::nullopt;
+        }
+        Chunk chunk = std::move(chunks.front());
+        chunks.pop_front();
+        notFull.notify_one();
+        return chunk;
+      }
+
+      void close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+      }
+
+      void cancel() {
+        std::lock_guard lock(mutex);
+        cancelled = true;
+        notFull.notify_all();
+      }
+
+    private:
+      std::mutex mutex;
+      std::condition_variable notEmpty;
+      std::condition_variable notFull;
+      std::deque<Chunk> chunks;
+      std::size_t capacity;
+      bool closed = false;
+      bool cancelled = false;
+  };
+
+  struct Options {
+    Format format = Format::TodoTxt;
+    long long batchRows = DEFAULT_BATCH_ROWS;
+    std::string path;
+  };
+
+  std::optional<Format> parseFormat(std::string value) {
+    lower(value);
+    if (value == "todotxt" || value == "todo.txt" || value == "txt") return Format::TodoTxt;
+    if (value == "csv") return Format::Csv;
+    if (value == "jsonl" || value == "ndjson") return Format::Jsonl;
+    return std::nullopt;
+  }
+
+  Options parseOptions(const std::string& description) {
+    Options options;
+    std::optional<Format> format;
+    std::vector<std::string> rest;
+
+    std::istringstream in(description);
+    std::string word;
+    while (in >> word) {
+      std::string value;
+      std::string option = word;
+      if (word.starts_with("--")) {
+        if (auto eq = word.find('='); eq != std::string::npos) {
+          value = word.substr(eq + 1);
+          option = word.substr(0, eq);
+        } else {
+          in >> value;
+        }
+      }
+
+      if (option == "--format") {
+        format = parseFormat(value);
+        if (!format) {
+          throw DatabaseException(std::format("Unknown import format '{}': expected todotxt, csv or jsonl.", value));
+        }
+      } else if (option == "--batch") {
+        options.batchRows = database::positiveNumber(option, value);
+      } else if (option.starts_with("--")) {
+        throw DatabaseException(std::format("Unknown import option '{}'.", option));
+      } else {
+        rest.push_back(word);
+      }
+    }
+
+    // Whatever is left is the path; joinArguments() already split it on spaces.
+    for (const auto& part : rest) {
+      if (!options.path.empty()) {
+        options.path.push_back(' ');
+      }
+      options.path += part;
+    }
+    if (options.path.empty()) {
+      throw DatabaseException("No input given: pass a file name, or - for standard input.");
+    }
+
+    if (!format) {
+      std::string extension = options.path.substr(std::min(options.path.rfind('.'), options.path.size()));
+      format = extension.empty() ? std::nullopt : parseFormat(extension.substr(1));
+    }
+    if (!format) {
+      throw DatabaseException("Cannot tell the input format; pass --format=todotxt|csv|jsonl.");
+    }
+    options.format = *format;
+    return options;
+  }
+
+  std::string_view trim(std::string_view s) {
+    const auto first = s.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) {
+      return {};
+    }
+    return s.substr(first, s.find_last_not_of(" \t\r\n") - first + 1);
+  }
+
+  bool allDigits(std::string_view s) {
+    return !s.empty() && std::all_of(s.begin(), s.end(), [](unsigned char c) { return std::isdigit(c); });
+  }
+
+  // Epoch seconds, or a local date/time in one of the usual ISO-like shapes.
+  std::optional<long long> parseTimestamp(std::string_view text) {
+    text = trim(text);
+    if (text.empty()) {
+      return std::nullopt;
+    }
+    if (allDigits(text) || (text.front() == '-' && allDigits(text.substr(1)))) {
+      try {
+        return std::stoll(std::string(text));
+      } catch (const std::out_of_range&) {
+        throw ImportError(std::format("timestamp '{}' out of range", text));
+      }
+    }
+
+    static constexpr const char* layouts[] = {
+      "%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%dT%H:%M", "%Y-%m-%d",
+    };
+    for (const char* layout : layouts) {
+      std::tm local{};
+      std::istringstream in{std::string(text)};
+      in >> std::get_time(&local, layout);
+      if (!in.fail() && in.peek() == std::char_traits<char>::eof()) {
+        local.tm_isdst = -1;
+        return static_cast<long long>(std::mktime(&local));
+      }
+    }
+    throw ImportError(std::format("invalid timestamp '{}'", text));
+  }
+
+  bool parseCompleted(std::string value) {
+    value = std::string(trim(value));
+    lower(value);
+    if (value.empty() || value == "pending" || value == "0" || value == "false") return false;
+    if (value == "done" || value == "completed" || value == "complete" || value == "1" || value == "true" ||
+        value == "x") {
+      return true;
+    }
+    throw ImportError(std::format("invalid status '{}'", value));
+  }
+
+  bool isTodoDate(std::string_view word) {
+    return word.size() == 10 && word[4] == '-' && word[7] == '-' && allDigits(word.substr(0, 4)) &&
+           allDigits(word.substr(5, 2)) && allDigits(word.substr(8, 2));
+  }
+
+  // Splits off the next space-separated word of `line` if `accept` likes it.
+  template <typename Predicate>
+  std::optional<std::string_view> takeWord(std::string_view& line, Predicate accept) {
+    const auto end = line.find(' ');
+    std::string_view word = line.substr(0, end);
+    if (!accept(word)) {
+      return std::nullopt;
+    }
+    line = end == std::string_view::npos ? std::string_view{} : trim(line.substr(end + 1));
+    return word;
+  }
+
+  // todo.txt: [x [completion-date]] [(A)] [creation-date] text
+  ImportedTask parseTodoTxt(std::string_view line) {
+    ImportedTask task;
+    if (takeWord(line, [](std::string_view w) { return w == "x"; })) {
+      task.completed = true;
+      if (auto date = takeWord(line, isTodoDate)) {
+        task.completedAt = parseTimestamp(*date);
+      }
+    }
+
+    std::string priority;
+    if (auto pri = takeWord(line, [](std::string_view w) {
+          return w.size() == 3 && w[0] == '(' && std::isupper(static_cast<unsigned char>(w[1])) && w[2] == ')';
+        })) {
+      priority = std::string(*pri) + " ";
+    }
+
+    if (auto date = takeWord(line, isTodoDate)) {
+      task.createdAt = parseTimestamp(*date);
+    }
+
+    if (line.empty()) {
+      throw ImportError("empty task text");
+    }
+    task.task = priority + std::string(line);
+    return task;
+  }
+
+  // Reads one RFC 4180 record; quoted fields may contain commas, "" and newlines.
+  bool readCsvRecord(std::istream& in, std::vector<std::string>& fields) {
+    fields.clear();
+    if (in.peek() == std::char_traits<char>::eof()) {
+      return false;
+    }
+
+    std::string field;
+    bool quoted = false;
+    int c;
+    while ((c = in.get()) != std::char_traits<char>::eof()) {
+      if (quoted) {
+        if (c == '"') {
+          if (in.peek() == '"') {
+            field.push_back('"');
+            in.get();
+          } else {
+            quoted = false;
+          }
+        } else {
+          field.push_back(static_cast<char>(c));
+        }
+      } else if (c == '"') {
+        quoted = true;
+      } else if (c == ',') {
+        fields.push_back(std::move(field));
+        field.clear();
+      } else if (c == '\n') {
+        break;
+      } else if (c != '\r') {
+        field.push_back(static_cast<char>(c));
+      }
+    }
+    if (quoted) {
+      throw ImportError("unterminated quoted field");
+    }
+    fields.push_back(std::move(field));
+    return true;
+  }
+
+  void appendUtf8(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+      out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+  }
+
+  // Just enough JSON for one flat object per line: string, number, true/false/null
+  // values. Every value is returned as text; null becomes an absent key.
+  class JsonObjectParser {
+    public:
+      explicit JsonObjectParser(std::string_view text) : text(text) {}
+
+      std::unordered_map<std::string, std::string> parse() {
+        std::unordered_map<std::string, std::string> object;
+        expect('{');
+        skipSpace();
+        if (peek() == '}') {
+          pos++;
+        } else {
+          while (true) {
+            skipSpace();
+            std::string key = parseString();
+            skipSpace();
+            expect(':');
+            skipSpace();
+            if (auto value = parseValue()) {
+              object[std::move(key)] = std::move(*value);
+            }
+            skipSpace();
+            if (peek() == ',') {
+              pos++;
+              continue;
+            }
+            expect('}');
+            break;
+          }
+        }
+        skipSpace();
+        if (pos != text.size()) {
+          fail("trailing characters after object");
+        }
+        return object;
+      }
+
+    private:
+      [[noreturn]] void fail(std::string_view what) {
+        throw ImportError(std::format("invalid JSON at column {}: {}", pos + 1, what));
+      }
+
+      char peek() const { return pos < text.size() ? text[pos] : '\0'; }
+
+      void skipSpace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+          pos++;
+        }
+      }
+
+      void expect(char c) {
+        if (peek() != c) {
+          fail(std::format("expected '{}'", c));
+        }
+        pos++;
+      }
+
+      unsigned hex4() {
+        if (pos + 4 > text.size()) {
+          fail("truncated \\u escape");
+        }
+        unsigned value = 0;
+        for (int i = 0; i < 4; i++) {
+          const char c = text[pos++];
+          value <<= 4;
+          if (c >= '0' && c <= '9') value |= static_cast<unsigned>(c - '0');
+          else if (c >= 'a' && c <= 'f') value |= static_cast<unsigned>(c - 'a' + 10);
+          else if (c >= 'A' && c <= 'F') value |= static_cast<unsigned>(c - 'A' + 10);
+          else fail("bad \\u escape");
+        }
+        return value;
+      }
+
+      std::string parseString() {
+        expect('"');
+        std::string out;
+        while (true) {
+          if (pos >= text.size()) {
+            fail("unterminated string");
+          }
+          const char c = text[pos++];
+          if (c == '"') {
+            return out;
+          }
+          if (c != '\\') {
+            out.push_back(c);
+            continue;
+          }
+
+          const char escape = peek();
+          pos++;
+          switch (escape) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+              char32_t cp = hex4();
+              if (cp >= 0xD800 && cp <= 0xDBFF && text.substr(pos, 2) == "\\u") {
+                pos += 2;
+                const char32_t low = hex4();
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+              }
+              appendUtf8(out, cp);
+            } break;
+            default:
+              fail("bad escape");
+          }
+        }
+      }
+
+      std::optional<std::string> parseValue() {
+        const char c = peek();
+        if (c == '"') {
+          return parseString();
+        }
+        for (std::string_view literal : {"true", "false", "null"}) {
+          if (text.substr(pos, literal.size()) == literal) {
+            pos += literal.size();
+            return literal == "null" ? std::nullopt : std::optional<std::string>(literal);
+          }
+        }
+        const std::size_t start = pos;
+        while (pos < text.size() && (std::isdigit(static_cast<unsigned char>(text[pos])) || text[pos] == '-' ||
+                                     text[pos] == '+' || text[pos] == '.' || text[pos] == 'e' || text[pos] == 'E')) {
+          pos++;
+        }
+        if (pos == start) {
+          fail("unsupported value (nested objects and arrays are not imported)");
+        }
+        std::string number(text.substr(start, pos - start));
+        // Whole-second timestamps may arrive as 1.7e9 or 1700000000.0.
+        if (number.find_first_of(".eE") != std::string::npos) {
+          try {
+            number = std::to_string(static_cast<long long>(std::stod(number)));
+          } catch (const std::exception&) {
+            fail("bad number");
+          }
+        }
+        return number;
+      }
+
+      std::string_view text;
+      std::size_t pos = 0;
+  };
+
+  ImportedTask taskFromFields(const std::unordered_map<std::string, std::string>& fields) {
+    auto field = [&](std::initializer_list<std::string_view> names) -> const std::string* {
+      for (std::string_view name : names) {
+        if (auto it = fields.find(std::string(name)); it != fields.end()) {
+          return &it->second;
+        }
+      }
+      return nullptr;
+    };
+
+    ImportedTask task;
+    const std::string* text = field({"task", "text", "description"});
+    if (!text || trim(*text).empty()) {
+      throw ImportError("missing task text");
+    }
+    task.task = *text;
+
+    if (const std::string* status = field({"status", "state", "completed", "done"})) {
+      task.completed = parseCompleted(*status);
+    }
+    if (const std::string* created = field({"created_at", "created"})) {
+      task.createdAt = parseTimestamp(*created);
+    }
+    if (const std::string* completed = field({"completed_at", "done_at"})) {
+      task.completedAt = parseTimestamp(*completed);
+      task.completed = task.completed || task.completedAt.has_value();
+    }
+    return task;
+  }
+
+  // Runs on the parser thread: reads `in` record by record and queues chunks of tasks.
+  class Parser {
+    public:
+      Parser(std::istream& in, Format format, ChunkQueue& queue) : in(in), format(format), queue(queue) {}
+
+      void run() {
+        try {
+          switch (format) {
+            case Format::TodoTxt:
+              parseLines([](std::string_view line) { return parseTodoTxt(line); });
+              break;
+            case Format::Jsonl:
+              parseLines([](std::string_view line) { return taskFromFields(JsonObjectParser(line).parse()); });
+              break;
+            case Format::Csv:
+              parseCsv();
+              break;
+          }
+          flush();
+        } catch (...) {
+          failure = std::current_exception();
+        }
+        queue.close();
+      }
+
+      long long skipped = 0;
+      std::exception_ptr failure;
+
+    private:
+      void emit(ImportedTask task) {
+        chunk.push_back(std::move(task));
+        if (chunk.size() == CHUNK_ROWS) {
+          flush();
+        }
+      }
+
+      void flush() {
+        if (!chunk.empty() && !queue.push(std::move(chunk))) {
+          throw std::runtime_error("import cancelled");
+        }
+        chunk = Chunk();
+        chunk.reserve(CHUNK_ROWS);
+      }
+
+      void skip(long long record, const ImportError& e) {
+        skipped++;
+        std::println(stderr, "Skipping record {}: {}", record, e.what());
+      }
+
+      template <typename ParseLine>
+      void parseLines(ParseLine parseLine) {
+        std::string line;
+        long long number = 0;
+        while (std::getline(in, line)) {
+          number++;
+          if (trim(line).empty()) {
+            continue;
+          }
+          try {
+            emit(parseLine(trim(line)));
+          } catch (const ImportError& e) {
+            skip(number, e);
+          }
+        }
+      }
+
+      void parseCsv() {
+        std::vector<std::string> fields;
+        if (!readCsvRecord(in, fields)) {
+          return;
+        }
+        std::vector<std::string> header;
+        for (auto& name : fields) {
+          std::string key(trim(name));
+          lower(key);
+          header.push_back(std::move(key));
+        }
+        if (std::none_of(header.begin(), header.end(),
+                         [](const std::string& k) { return k == "task" || k == "text" || k == "description"; })) {
+          throw DatabaseException("CSV header has no task column.");
+        }
+
+        std::unordered_map<std::string, std::string> record;
+        long long number = 1;
+        while (true) {
+          number++;
+          try {
+            if (!readCsvRecord(in, fields)) {
+              break;
+            }
+            if (fields.size() == 1 && trim(fields[0]).empty()) {
+              continue;
+            }
+            record.clear();
+            for (std::size_t i = 0; i < fields.size() && i < header.size(); i++) {
+              record[header[i]] = std::move(fields[i]);
+            }
+            emit(taskFromFields(record));
+          } catch (const ImportError& e) {
+            skip(number, e);
+          }
+        }
+      }
+
+      std::istream& in;
+      Format format;
+      ChunkQueue& queue;
+      Chunk chunk;
+  };
+} // private namespace
+
+namespace importer {
+  bool importTasks(Database& db, const ParsedCommand& pc) {
+    long long imported = 0;
+    long long completed = 0;
+    try {
+      const Options options = parseOptions(pc.description);
+
+      std::ifstream file;
+      std::vector<char> buffer(READ_BUFFER_BYTES);
+      if (options.path != "-") {
+        file.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        file.open(options.path, std::ios::binary);
+        if (!file) {
+          throw DatabaseException(std::format("Cannot open '{}'.", options.path));
+        }
+      }
+      std::istream& in = options.path == "-" ? std::cin : file;
+
+      const auto started = std::chrono::steady_clock::now();
+      ChunkQueue queue(QUEUE_CHUNKS);
+      Parser parser(in, options.format, queue);
+      std::thread parserThread(&Parser::run, &parser);
+
+      try {
+        auto stmt = db.prepare(Queries::IMPORT_TASK_QUERY);
+        std::optional<Transaction> transaction;
+        sqlite3_int64 lastIdBefore = 0;
+        long long inBatch = 0;
+        long long completedInBatch = 0;
+
+        auto beginBatch = [&] {
+          transaction.emplace(db, Queries::BEGIN_IMMEDIATE_QUERY);
+          database::execOrThrow(db, Queries::DROP_FTS_INSERT_TRIGGER_QUERY);
+          database::execOrThrow(db, Queries::DROP_COUNTERS_INSERT_TRIGGER_QUERY);
+          database::execOrThrow(db, Queries::DROP_WRITES_INSERT_TRIGGER_QUERY);
+          auto maxId = db.prepare(Queries::MAX_TASK_ID_QUERY);
+          lastIdBefore = sqlite3_step(maxId.get()) == SQLITE_ROW ? sqlite3_column_int64(maxId.get(), 0) : 0;
+        };
+        auto commitBatch = [&] {
+          auto index = db.prepare(Queries::INDEX_TASKS_AFTER_ID_QUERY);
+          sqlite3_bind_int64(index.get(), 1, lastIdBefore);
+          if (sqlite3_step(index.get()) != SQLITE_DONE) {
+            throw DatabaseException(std::format("Indexing imported tasks failed: {}", sqlite3_errmsg(db.get())));
+          }
+          database::execOrThrow(db, Queries::CREATE_FTS_INSERT_TRIGGER_QUERY);
+          for (std::string_view query : Queries::UPDATE_COUNTERS_AFTER_ID_QUERIES) {
+            auto count = db.prepare(query);
+            sqlite3_bind_int64(count.get(), 1, lastIdBefore);
+            if (sqlite3_step(count.get()) != SQLITE_DONE) {
+              throw DatabaseException(std::format("Counting imported tasks failed: {}", sqlite3_errmsg(db.get())));
+            }
+          }
+          database::execOrThrow(db, Queries::CREATE_COUNTERS_INSERT_TRIGGER_QUERY);
+          auto writes = db.prepare(Queries::ADD_WRITES_QUERY);
+          sqlite3_bind_int64(writes.get(), 1, inBatch);
+          if (sqlite3_step(writes.get()) != SQLITE_DONE) {
+            throw DatabaseException(std::format("Counting imported writes failed: {}", sqlite3_errmsg(db.get())));
+          }
+          database::execOrThrow(db, Queries::CREATE_WRITES_INSERT_TRIGGER_QUERY);
+          transaction->commit();
+          imported += inBatch;
+          completed += completedInBatch;
+          inBatch = 0;
+          completedInBatch = 0;
+        };
+
+        beginBatch();
+        while (auto chunk = queue.pop()) {
+          for (const ImportedTask& task : *chunk) {
+            sqlite3_bind_text(stmt.get(), 1, task.task.data(), static_cast<int>(task.task.size()), SQLITE_STATIC);
+            sqlite3_bind_int(stmt.get(), 2, static_cast<int>(task.completed ? TaskStatus::Completed : TaskStatus::Pending));
+            task.createdAt ? sqlite3_bind_int64(stmt.get(), 3, *task.createdAt) : sqlite3_bind_null(stmt.get(), 3);
+            task.completedAt ? sqlite3_bind_int64(stmt.get(), 4, *task.completedAt) : sqlite3_bind_null(stmt.get(), 4);
+
+            int rc = sqlite3_step(stmt.get());
+            sqlite3_reset(stmt.get());
+            if (rc != SQLITE_DONE) {
+              throw DatabaseException(std::format("Insert failed (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+            }
+
+            completedInBatch += task.completed ? 1 : 0;
+            if (++inBatch == options.batchRows) {
+              commitBatch();
+              beginBatch();
+            }
+          }
+        }
+        commitBatch();
+      } catch (...) {
+        queue.cancel();
+        parserThread.join();
+        throw;
+      }
+
+      parserThread.join();
+      if (parser.failure) {
+        std::rethrow_exception(parser.failure);
+      }
+
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+      std::println("Imported {} tasks ({} pending, {} completed) in {:.2f} s, {:.0f} rows/s.", imported,
+                   imported - completed, completed, seconds, seconds > 0 ? imported / seconds : 0.0);
+      if (parser.skipped > 0) {
+        std::println("Skipped {} malformed records.", parser.skipped);
+      }
+      return true;
+    } catch (const DatabaseException& e) {
+      std::println(stderr, "DB Error importing tasks: {}", e.what());
+    } catch (const std::exception& e) {
+      std::println(stderr, "General Error in importTasks: {}", e.what());
+    }
+
+    if (imported > 0) {
+      std::println(stderr, "{} tasks from earlier batches were committed.", imported);
+    }
+    return false;
+  }
+} // importer
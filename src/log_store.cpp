@@ -0,0 +1,683 @@
+#include <print>
+#include <array>
+#include <ctime>
+#include <cerrno>
+#include <cstdio>
+#include <format>
+#include <random>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "paths.hpp"
+#include "matcher.hpp"
+#include "settings.hpp"
+#include "database.hpp"
+#include "log_store.hpp"
+
+namespace {
+  constexpr char LOG_MAGIC[8] = {'N', 'U', 'D', 'G', 'L', 'O', 'G', '1'};
+  constexpr char INDEX_MAGIC[8] = {'N', 'U', 'D', 'G', 'I', 'D', 'X', '1'};
+  constexpr std::uint64_t LOG_HEADER_BYTES = sizeof(LOG_MAGIC) + sizeof(std::uint64_t);
+  // crc32 and payload length in front of every record.
+  constexpr std::uint64_t FRAME_BYTES = 2 * sizeof(std::uint32_t);
+  // type, id and time at the start of every payload.
+  constexpr std::uint32_t PAYLOAD_BYTES = 1 + 2 * sizeof(std::int64_t);
+  constexpr std::uint32_t SNAPSHOT_BYTES = PAYLOAD_BYTES + sizeof(std::int64_t);
+  constexpr std::size_t MAX_TEXT_BYTES = 1 << 24;
+  constexpr std::size_t INITIAL_SLOTS = 1024;
+  constexpr std::size_t COMPACT_WRITE_BYTES = 1 << 20;
+  // Below this size compaction is not worth a rewrite.
+  constexpr std::uint64_t COMPACT_MIN_BYTES = 1 << 20;
+
+  enum RecordType : std::uint8_t {
+    Add = 1,
+    Complete = 2,
+    Delete = 3,
+    Snapshot = 4, // a live task as written by compaction, with its completion time (0 while pending)
+    Sequence = 5, // the highest id assigned so far, so compaction never makes ids reusable
+  };
+
+  enum SlotState : std::uint32_t {
+    Empty = 0,
+    Pending = 1,
+    Completed = 2,
+  };
+
+  constexpr std::array<std::uint32_t, 256> CRC_TABLE = [] {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; i++) {
+      std::uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      table[i] = c;
+    }
+    return table;
+  }();
+
+  // CRC-32 (IEEE 802.3), as used by zlib and gzip.
+  std::uint32_t crc32(const char* data, std::size_t size) {
+    std::uint32_t c = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < size; i++) {
+      c = CRC_TABLE[(c ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+  }
+
+  template <typename T>
+  void put(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+  }
+
+  template <typename T>
+  T get(const char* bytes) {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+  }
+
+  // Appends one framed record to `out`. Returns the offset of its text within `out`.
+  std::size_t encodeRecord(std::string& out, std::uint8_t type, std::int64_t id, std::int64_t time,
+                           std::int64_t completedAt, std::string_view text) {
+    const std::size_t start = out.size();
+    const auto length = static_cast<std::uint32_t>((type == Snapshot ? SNAPSHOT_BYTES : PAYLOAD_BYTES) + text.size());
+    put<std::uint32_t>(out, 0);
+    put(out, length);
+    put(out, type);
+    put(out, id);
+    put(out, time);
+    if (type == Snapshot) {
+      put(out, completedAt);
+    }
+    const std::size_t textStart = out.size();
+    out.append(text);
+
+    const std::uint32_t crc = crc32(out.data() + start + sizeof(std::uint32_t), length + sizeof(std::uint32_t));
+    std::memcpy(out.data() + start, &crc, sizeof(crc));
+    return textStart;
+  }
+
+  // Bytes a task takes up in a compacted log.
+  std::uint64_t liveBytes(const LogStore::Slot& s) {
+    return s.state == Empty ? 0 : FRAME_BYTES + SNAPSHOT_BYTES + s.textLength;
+  }
+
+  // Keeps the header's counters in step with one slot changing from `before` to `after`.
+  void account(LogStore::Header& header, const LogStore::Slot& before, const LogStore::Slot& after) {
+    header.pending -= before.state == Pending;
+    header.pending += after.state == Pending;
+    header.liveBytes -= liveBytes(before);
+    header.liveBytes += liveBytes(after);
+  }
+
+  std::uint64_t newGeneration() {
+    std::random_device random;
+    return (static_cast<std::uint64_t>(random()) << 32) ^ random();
+  }
+
+  std::int64_t now() {
+    return static_cast<std::int64_t>(std::time(nullptr));
+  }
+
+  bool durable() {
+    return settings::current().synchronous != Synchronous::Off;
+  }
+
+  [[noreturn]] void fail(const std::string& what, const std::filesystem::path& path) {
+    throw DatabaseException(std::format("{} {}: {}", what, path.string(), std::strerror(errno)));
+  }
+
+  void writeAll(int fd, const char* data, std::size_t size, const std::filesystem::path& path) {
+    while (size > 0) {
+      const ssize_t n = write(fd, data, size);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        fail("Cannot write", path);
+      }
+      data += n;
+      size -= static_cast<std::size_t>(n);
+    }
+  }
+} // private namespace
+
+LogStore::LogStore(Access access) : readOnly(access != Access::ReadWrite) {
+  lock(readOnly ? LOCK_SH : LOCK_EX);
+  // Creating the log or bringing the index up to date writes, so a reader
+  // that finds either needed takes the exclusive lock after all.
+  if (readOnly && !indexIsCurrent()) {
+    lock(LOCK_EX);
+  }
+  openLog();
+  openIndex();
+}
+
+LogStore::~LogStore() {
+  if (logMap) {
+    munmap(const_cast<char*>(logMap), logMapped);
+  }
+  if (header) {
+    munmap(header, sizeof(Header) + indexCapacity * sizeof(Slot));
+  }
+  for (int fd : {indexFd, logFd, lockFd}) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+// One writer, or any number of readers, at a time; compaction replaces
+// tasks.log, so the lock lives in a file of its own. Taking LOCK_EX while
+// holding LOCK_SH converts the lock, which may let a writer in between.
+void LogStore::lock(int operation) {
+  if (lockFd < 0) {
+    std::filesystem::create_directories(Paths::configDirectoryPath());
+    lockFd = open(Paths::logLockPath().c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFd < 0) {
+      fail("Cannot open", Paths::logLockPath());
+    }
+  }
+  while (flock(lockFd, operation) != 0) {
+    if (errno != EINTR) {
+      fail("Cannot lock", Paths::logLockPath());
+    }
+  }
+}
+
+// True when opening would write nothing: the log has its header and the
+// index matches its generation and covers all of it.
+bool LogStore::indexIsCurrent() const {
+  struct stat logInfo{};
+  struct stat indexInfo{};
+  if (stat(Paths::logPath().c_str(), &logInfo) != 0 || stat(Paths::logIndexPath().c_str(), &indexInfo) != 0 ||
+      static_cast<std::uint64_t>(logInfo.st_size) < LOG_HEADER_BYTES ||
+      static_cast<std::size_t>(indexInfo.st_size) < sizeof(Header) + sizeof(Slot)) {
+    return false;
+  }
+
+  char start[LOG_HEADER_BYTES];
+  Header stored{};
+  const int log = open(Paths::logPath().c_str(), O_RDONLY | O_CLOEXEC);
+  const bool logRead = log >= 0 && pread(log, start, sizeof(start), 0) == static_cast<ssize_t>(sizeof(start));
+  if (log >= 0) {
+    close(log);
+  }
+  const int index = open(Paths::logIndexPath().c_str(), O_RDONLY | O_CLOEXEC);
+  const bool indexRead = index >= 0 && pread(index, &stored, sizeof(stored), 0) == static_cast<ssize_t>(sizeof(stored));
+  if (index >= 0) {
+    close(index);
+  }
+
+  const auto capacity = (static_cast<std::size_t>(indexInfo.st_size) - sizeof(Header)) / sizeof(Slot);
+  return logRead && indexRead && std::memcmp(start, LOG_MAGIC, sizeof(LOG_MAGIC)) == 0 &&
+         std::memcmp(stored.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+         stored.generation == get<std::uint64_t>(start + sizeof(LOG_MAGIC)) &&
+         stored.covered == static_cast<std::uint64_t>(logInfo.st_size) && stored.slots <= capacity;
+}
+
+void LogStore::requireWritable() const {
+  if (readOnly) {
+    throw DatabaseException(std::format("{} is open read-only.", Paths::logPath().string()));
+  }
+}
+
+void LogStore::openLog() {
+  logFd = open(Paths::logPath().c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (logFd < 0) {
+    fail("Cannot open", Paths::logPath());
+  }
+
+  struct stat info{};
+  if (fstat(logFd, &info) != 0) {
+    fail("Cannot stat", Paths::logPath());
+  }
+  logSize = static_cast<std::uint64_t>(info.st_size);
+
+  if (logSize >= LOG_HEADER_BYTES) {
+    char start[LOG_HEADER_BYTES];
+    if (pread(logFd, start, sizeof(start), 0) != static_cast<ssize_t>(sizeof(start))) {
+      fail("Cannot read", Paths::logPath());
+    }
+    if (std::memcmp(start, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+      throw DatabaseException(std::format("{} is not a Nudge task log.", Paths::logPath().string()));
+    }
+    generation = get<std::uint64_t>(start + sizeof(LOG_MAGIC));
+  } else {
+    // New, or cut short while its header was being written: nothing in it can be a record yet.
+    generation = newGeneration();
+    std::string fresh(LOG_MAGIC, sizeof(LOG_MAGIC));
+    put(fresh, generation);
+    if (ftruncate(logFd, 0) != 0) {
+      fail("Cannot truncate", Paths::logPath());
+    }
+    writeAll(logFd, fresh.data(), fresh.size(), Paths::logPath());
+    if (durable()) {
+      fsync(logFd);
+    }
+    logSize = LOG_HEADER_BYTES;
+  }
+
+  mapLog();
+}
+
+void LogStore::mapLog() {
+  if (logMap) {
+    munmap(const_cast<char*>(logMap), logMapped);
+    logMap = nullptr;
+    logMapped = 0;
+  }
+  void* map = mmap(nullptr, logSize, PROT_READ, MAP_SHARED, logFd, 0);
+  if (map == MAP_FAILED) {
+    fail("Cannot map", Paths::logPath());
+  }
+  logMap = static_cast<const char*>(map);
+  logMapped = logSize;
+}
+
+void LogStore::mapIndex(std::size_t capacity) {
+  if (header) {
+    munmap(header, sizeof(Header) + indexCapacity * sizeof(Slot));
+    header = nullptr;
+    slotTable = nullptr;
+  }
+  void* map = mmap(nullptr, sizeof(Header) + capacity * sizeof(Slot), PROT_READ | PROT_WRITE, MAP_SHARED, indexFd, 0);
+  if (map == MAP_FAILED) {
+    fail("Cannot map", Paths::logIndexPath());
+  }
+  header = static_cast<Header*>(map);
+  slotTable = reinterpret_cast<Slot*>(static_cast<char*>(map) + sizeof(Header));
+  indexCapacity = capacity;
+}
+
+void LogStore::ensureCapacity(std::uint64_t slots) {
+  if (slots <= indexCapacity) {
+    return;
+  }
+  const std::size_t capacity = std::max<std::size_t>(slots, indexCapacity * 2);
+  if (ftruncate(indexFd, static_cast<off_t>(sizeof(Header) + capacity * sizeof(Slot))) != 0) {
+    fail("Cannot grow", Paths::logIndexPath());
+  }
+  mapIndex(capacity);
+}
+
+void LogStore::resetIndex() {
+  if (ftruncate(indexFd, 0) != 0 ||
+      ftruncate(indexFd, static_cast<off_t>(sizeof(Header) + INITIAL_SLOTS * sizeof(Slot))) != 0) {
+    fail("Cannot reset", Paths::logIndexPath());
+  }
+  mapIndex(INITIAL_SLOTS);
+  std::memcpy(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  header->generation = generation;
+  header->covered = LOG_HEADER_BYTES;
+}
+
+void LogStore::openIndex() {
+  indexFd = open(Paths::logIndexPath().c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (indexFd < 0) {
+    fail("Cannot open", Paths::logIndexPath());
+  }
+
+  struct stat info{};
+  if (fstat(indexFd, &info) != 0) {
+    fail("Cannot stat", Paths::logIndexPath());
+  }
+
+  const auto size = static_cast<std::size_t>(info.st_size);
+  bool valid = size >= sizeof(Header) + sizeof(Slot);
+  if (valid) {
+    mapIndex((size - sizeof(Header)) / sizeof(Slot));
+    valid = std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+            header->generation == generation &&
+            header->covered >= LOG_HEADER_BYTES && header->covered <= logSize &&
+            header->slots <= indexCapacity;
+  }
+  if (!valid) {
+    resetIndex();
+  }
+
+  replay(header->covered);
+  next = *header;
+}
+
+void LogStore::replay(std::uint64_t from) {
+  std::uint64_t offset = from;
+  while (offset + FRAME_BYTES <= logSize) {
+    const char* frame = logMap + offset;
+    const auto length = get<std::uint32_t>(frame + sizeof(std::uint32_t));
+    if (length < PAYLOAD_BYTES || offset + FRAME_BYTES + length > logSize ||
+        get<std::uint32_t>(frame) != crc32(frame + sizeof(std::uint32_t), length + sizeof(std::uint32_t))) {
+      break;
+    }
+
+    const char* payload = frame + FRAME_BYTES;
+    const auto type = get<std::uint8_t>(payload);
+    const auto id = get<std::int64_t>(payload + 1);
+    const auto time = get<std::int64_t>(payload + 1 + sizeof(std::int64_t));
+    const std::uint64_t payloadOffset = offset + FRAME_BYTES;
+    if (type == Snapshot && length >= SNAPSHOT_BYTES) {
+      apply(type, id, time, payloadOffset + SNAPSHOT_BYTES, length - SNAPSHOT_BYTES,
+            get<std::int64_t>(payload + PAYLOAD_BYTES));
+    } else {
+      apply(type, id, time, payloadOffset + PAYLOAD_BYTES, length - PAYLOAD_BYTES, 0);
+    }
+    offset += FRAME_BYTES + length;
+  }
+
+  // Anything after the last whole record is a write that never finished.
+  if (offset < logSize) {
+    std::println(stderr, "{}: dropped {} bytes of an incomplete record at the end.", Paths::logPath().string(),
+                 logSize - offset);
+    if (ftruncate(logFd, static_cast<off_t>(offset)) != 0) {
+      fail("Cannot truncate", Paths::logPath());
+    }
+    if (durable()) {
+      fdatasync(logFd);
+    }
+    logSize = offset;
+    mapLog();
+  }
+
+  if (offset != header->covered) {
+    recount();
+    if (durable()) {
+      msync(header, sizeof(Header) + indexCapacity * sizeof(Slot), MS_SYNC);
+    }
+    header->covered = offset;
+  }
+}
+
+// A crash inside commit() can leave slots that already reflect records the
+// header's covered offset does not, so replaying those records proves nothing
+// about the header's counters. After any replay they are taken from the slots.
+void LogStore::recount() {
+  header->pending = 0;
+  header->liveBytes = 0;
+  for (std::uint64_t i = 0; i < header->slots; i++) {
+    header->pending += slotTable[i].state == Pending;
+    header->liveBytes += liveBytes(slotTable[i]);
+  }
+}
+
+void LogStore::apply(std::uint8_t type, std::int64_t id, std::int64_t time, std::uint64_t textOffset,
+                     std::uint32_t textLength, std::int64_t completedAt) {
+  if (id < 1) {
+    return;
+  }
+  const auto slots = static_cast<std::uint64_t>(id);
+  ensureCapacity(slots);
+  header->slots = std::max(header->slots, slots);
+  if (type == Sequence) {
+    return;
+  }
+
+  // The header's counters are rebuilt by recount() once replay() is done.
+  Slot& current = slotTable[id - 1];
+  switch (type) {
+    case Add:
+    case Snapshot:
+      // A slot pointing at this record's text already reflects it, and maybe a
+      // later completion that must not be undone.
+      if (current.state != Empty && current.textOffset == textOffset) {
+        break;
+      }
+      current = Slot{textOffset, time, completedAt, completedAt ? Completed : Pending, textLength};
+      break;
+    case Complete:
+      if (current.state == Pending) {
+        current.state = Completed;
+        current.completedAt = time;
+      }
+      break;
+    case Delete:
+      current = Slot{};
+      break;
+    default:
+      break;
+  }
+}
+
+LogStore::Slot LogStore::slot(long long id) const {
+  if (auto it = staged.find(id); it != staged.end()) {
+    return it->second;
+  }
+  if (id < 1 || static_cast<std::uint64_t>(id) > indexCapacity) {
+    return Slot{};
+  }
+  return slotTable[id - 1];
+}
+
+void LogStore::stage(long long id, const Slot& updated) {
+  account(next, slot(id), updated);
+  staged[id] = updated;
+}
+
+std::string_view LogStore::textAt(std::uint64_t offset, std::uint32_t length) const {
+  if (offset + length <= logMapped) {
+    return {logMap + offset, length};
+  }
+  // Appended after the log was mapped.
+  textBuffer.resize(length);
+  if (pread(logFd, textBuffer.data(), length, static_cast<off_t>(offset)) != static_cast<ssize_t>(length)) {
+    fail("Cannot read", Paths::logPath());
+  }
+  return textBuffer;
+}
+
+Task LogStore::taskAt(long long id, const Slot& s) const {
+  Task task;
+  task.id = id;
+  task.text = std::string(textAt(s.textOffset, s.textLength));
+  task.status = s.state == Completed ? TaskStatus::Completed : TaskStatus::Pending;
+  task.createdAt = s.createdAt;
+  if (s.state == Completed) {
+    task.completedAt = s.completedAt;
+  }
+  return task;
+}
+
+void LogStore::appendRecord(std::uint8_t type, std::int64_t id, std::int64_t time, std::string_view text,
+                            std::int64_t completedAt) {
+  requireWritable();
+  encodeRecord(pendingRecords, type, id, time, completedAt, text);
+}
+
+void LogStore::completeSlot(long long id, std::int64_t when, const TaskVisitor& visit) {
+  Slot updated = slot(id);
+  updated.state = Completed;
+  updated.completedAt = when;
+  appendRecord(Complete, id, when);
+  stage(id, updated);
+  visit(taskAt(id, updated));
+}
+
+// Log first, then the slots, then the covered offset: a crash at any point
+// leaves an index that replay() can bring up to date.
+void LogStore::commit() {
+  if (pendingRecords.empty()) {
+    return;
+  }
+
+  writeAll(logFd, pendingRecords.data(), pendingRecords.size(), Paths::logPath());
+  if (durable() && fdatasync(logFd) != 0) {
+    fail("Cannot sync", Paths::logPath());
+  }
+  logSize += pendingRecords.size();
+  pendingRecords.clear();
+
+  ensureCapacity(next.slots);
+  for (const auto& [id, s] : staged) {
+    slotTable[id - 1] = s;
+  }
+  staged.clear();
+  if (durable()) {
+    msync(header, sizeof(Header) + indexCapacity * sizeof(Slot), MS_SYNC);
+  }
+  next.covered = logSize;
+  *header = next;
+
+  if (logSize > COMPACT_MIN_BYTES && logSize > 2 * (LOG_HEADER_BYTES + FRAME_BYTES + PAYLOAD_BYTES + next.liveBytes)) {
+    compact();
+  }
+}
+
+void LogStore::compact() {
+  const std::filesystem::path temporary = Paths::logPath().string() + ".compact";
+  const int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    fail("Cannot create", temporary);
+  }
+
+  const std::uint64_t fresh = newGeneration();
+  std::string out(LOG_MAGIC, sizeof(LOG_MAGIC));
+  put(out, fresh);
+  encodeRecord(out, Sequence, static_cast<std::int64_t>(header->slots), 0, 0, {});
+  try {
+    for (std::uint64_t i = 0; i < header->slots; i++) {
+      const Slot& s = slotTable[i];
+      if (s.state == Empty) {
+        continue;
+      }
+      encodeRecord(out, Snapshot, static_cast<std::int64_t>(i + 1), s.createdAt,
+                   s.state == Completed ? s.completedAt : 0, textAt(s.textOffset, s.textLength));
+      if (out.size() >= COMPACT_WRITE_BYTES) {
+        writeAll(fd, out.data(), out.size(), temporary);
+        out.clear();
+      }
+    }
+    writeAll(fd, out.data(), out.size(), temporary);
+    if (durable() && fsync(fd) != 0) {
+      fail("Cannot sync", temporary);
+    }
+  } catch (...) {
+    close(fd);
+    std::filesystem::remove(temporary);
+    throw;
+  }
+  close(fd);
+
+  std::filesystem::rename(temporary, Paths::logPath());
+  if (durable()) {
+    const int directory = open(Paths::configDirectoryPath().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directory >= 0) {
+      fsync(directory);
+      close(directory);
+    }
+  }
+
+  // The new file carries a new generation, so the old index no longer matches and is rebuilt.
+  munmap(const_cast<char*>(logMap), logMapped);
+  logMap = nullptr;
+  close(logFd);
+  openLog();
+  resetIndex();
+  replay(LOG_HEADER_BYTES);
+  next = *header;
+}
+
+long long LogStore::add(std::string_view text) {
+  requireWritable();
+  if (text.size() > MAX_TEXT_BYTES) {
+    throw DatabaseException("Task text is too long.");
+  }
+
+  const auto id = static_cast<long long>(next.slots) + 1;
+  const std::int64_t created = now();
+  const std::uint64_t textOffset = logSize + encodeRecord(pendingRecords, Add, id, created, 0, text);
+  next.slots = static_cast<std::uint64_t>(id);
+  stage(id, Slot{textOffset, created, 0, Pending, static_cast<std::uint32_t>(text.size())});
+  commit();
+  return id;
+}
+
+bool LogStore::remove(long long id) {
+  if (slot(id).state != Pending) {
+    return false;
+  }
+  appendRecord(Delete, id, now());
+  stage(id, Slot{});
+  commit();
+  return true;
+}
+
+std::optional<Task> LogStore::completeById(long long id) {
+  if (slot(id).state != Pending) {
+    return std::nullopt;
+  }
+  std::optional<Task> completed;
+  completeSlot(id, now(), [&](const Task& task) { completed = task; });
+  commit();
+  return completed;
+}
+
+long long LogStore::completeByIds(std::span<const long long> ids, const TaskVisitor& visit) {
+  const std::int64_t when = now();
+  long long completed = 0;
+  for (long long id : ids) {
+    if (slot(id).state == Pending) {
+      completeSlot(id, when, visit);
+      completed++;
+    }
+  }
+  commit();
+  return completed;
+}
+
+long long LogStore::completeMatching(std::string_view pattern, const TaskVisitor& visit) {
+  const std::int64_t when = now();
+  long long completed = 0;
+  for (std::uint64_t i = 0; i < header->slots; i++) {
+    const Slot& s = slotTable[i];
+    if (s.state == Pending && matcher::containsIgnoreCase(textAt(s.textOffset, s.textLength), pattern)) {
+      completeSlot(static_cast<long long>(i + 1), when, visit);
+      completed++;
+    }
+  }
+  commit();
+  return completed;
+}
+
+long long LogStore::completeOlderThan(long long seconds, const TaskVisitor& visit) {
+  const std::int64_t when = now();
+  long long completed = 0;
+  for (std::uint64_t i = 0; i < header->slots; i++) {
+    const Slot& s = slotTable[i];
+    if (s.state == Pending && s.createdAt < when - seconds) {
+      completeSlot(static_cast<long long>(i + 1), when, visit);
+      completed++;
+    }
+  }
+  commit();
+  return completed;
+}
+
+std::optional<Task> LogStore::firstPending() {
+  for (std::uint64_t i = 0; i < header->slots; i++) {
+    if (slotTable[i].state == Pending) {
+      return taskAt(static_cast<long long>(i + 1), slotTable[i]);
+    }
+  }
+  return std::nullopt;
+}
+
+void LogStore::forEachPending(const TaskVisitor& visit) {
+  for (std::uint64_t i = header->slots; i > 0; i--) {
+    if (slotTable[i - 1].state == Pending) {
+      visit(taskAt(static_cast<long long>(i), slotTable[i - 1]));
+    }
+  }
+}
+
+long long LogStore::countPending() {
+  return static_cast<long long>(header->pending);
+}
@@ -1,15 +1,40 @@
+#include <cstdlib>
+#include <print>
+
 #include "setup.hpp"
 #include "flags.hpp"
+#include "server.hpp"
 
 int main(int argc, char* argv[]) {
   
-  // Setup database and config directory. 
-  initializeApplication();
-
   // Get command and description.
   ParsedCommand pc = parseCommand(argc, argv);
-  executeCommand(pc);
 
-  return 0;
+  // A running daemon already holds a warm session; hand the command to it.
+  if (pc.flag != Flag::DAEMON) {
+    if (auto status = server::forward(pc)) {
+      return *status;
+    }
+  }
+
+  // Setup database and config directory, and open the session used by the command.
+  Database db = initializeApplication(pc);
+
+  if (pc.flag == Flag::DAEMON) {
+    return server::run(db);
+  }
+
+  bool ok = executeCommand(db, pc);
+
+  // An in-memory session stores its changes back in the file before exiting.
+  ok = database::writeBack(db) && ok;
+
+  // NUDGE_STATS=1 reports how often the statement cache avoided re-parsing SQL.
+  if (std::getenv("NUDGE_STATS")) {
+    const auto& stats = db.cacheStats();
+    std::println(stderr, "statement cache: {} hits, {} misses", stats.hits, stats.misses);
+  }
+
+  return ok ? 0 : 1;
 }
 
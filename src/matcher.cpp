@@ -0,0 +1,301 @@
+#include <string>
+#include <algorithm>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NUDGE_MATCHER_X86 1
+#endif
+
+#include "sqlite3.h"
+#include "matcher.hpp"
+
+namespace {
+  inline unsigned char foldAscii(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : c;
+  }
+
+  bool isAscii(std::string_view s) {
+    return std::all_of(s.begin(), s.end(), [](unsigned char c) { return c < 0x80; });
+  }
+
+  // Compares `n` bytes of haystack against an already lower-cased needle.
+  inline bool equalsFolded(const unsigned char* text, const unsigned char* lowerNeedle, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+      if (foldAscii(text[i]) != lowerNeedle[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::size_t scalarFind(const unsigned char* text, std::size_t size, std::size_t from, const unsigned char* needle,
+                         std::size_t m) {
+    for (std::size_t i = from; i + m <= size; i++) {
+      if (foldAscii(text[i]) == needle[0] && equalsFolded(text + i + 1, needle + 1, m - 1)) {
+        return i;
+      }
+    }
+    return std::string_view::npos;
+  }
+
+#if defined(NUDGE_MATCHER_X86)
+  // Compares the folded first and last needle bytes against 16 (or 32) candidate
+  // positions at once and only verifies the middle where both match.
+  // Bytes >= 0x80 are negative as signed chars, so they never fall inside 'A'..'Z'.
+  inline __m128i foldBlock(__m128i block) {
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)),
+                                        _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+  }
+
+  std::size_t sse2Find(const unsigned char* text, std::size_t size, const unsigned char* needle, std::size_t m) {
+    const __m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+    const __m128i last = _mm_set1_epi8(static_cast<char>(needle[m - 1]));
+
+    std::size_t i = 0;
+    for (; i + m - 1 + 16 <= size; i += 16) {
+      const __m128i blockFirst = foldBlock(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)));
+      const __m128i blockLast = foldBlock(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1)));
+      unsigned mask = static_cast<unsigned>(
+              _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last))));
+
+      while (mask != 0) {
+        const unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+        if (m <= 2 || equalsFolded(text + i + bit + 1, needle + 1, m - 2)) {
+          return i + bit;
+        }
+        mask &= mask - 1;
+      }
+    }
+
+    return scalarFind(text, size, i, needle, m);
+  }
+
+#if defined(__GNUC__)
+  __attribute__((target("avx2"))) inline __m256i foldBlock256(__m256i block) {
+    const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('A' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), block));
+    return _mm256_or_si256(block, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+  }
+
+  __attribute__((target("avx2"))) std::size_t avx2Find(const unsigned char* text, std::size_t size,
+                                                       const unsigned char* needle, std::size_t m) {
+    // Most task text is shorter than one block; leave it to SSE2 before any
+    // 256-bit register is touched.
+    if (m - 1 + 32 > size) {
+      return sse2Find(text, size, needle, m);
+    }
+
+    const __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+    const __m256i last = _mm256_set1_epi8(static_cast<char>(needle[m - 1]));
+
+    std::size_t i = 0;
+    for (; i + m - 1 + 32 <= size; i += 32) {
+      const __m256i blockFirst = foldBlock256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i)));
+      const __m256i blockLast =
+              foldBlock256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1)));
+      unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+              _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last))));
+
+      while (mask != 0) {
+        const unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+        if (m <= 2 || equalsFolded(text + i + bit + 1, needle + 1, m - 2)) {
+          return i + bit;
+        }
+        mask &= mask - 1;
+      }
+    }
+
+    // Finish the tail 16 bytes at a time. The SSE2 code is not VEX-encoded, so
+    // clear the upper halves first or every instruction in it pays a state
+    // transition.
+    _mm256_zeroupper();
+    const std::size_t rest = sse2Find(text + i, size - i, needle, m);
+    return rest == std::string_view::npos ? rest : i + rest;
+  }
+
+  bool cpuHasAvx2() {
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return supported;
+  }
+#endif
+#endif
+
+  // The fastest kernel the CPU supports.
+  bool fastestAsciiContains(std::string_view haystack, std::string_view lowerNeedle) {
+#if defined(NUDGE_MATCHER_X86) && defined(__GNUC__)
+    if (cpuHasAvx2()) {
+      return matcher::asciiContains(matcher::Kernel::Avx2, haystack, lowerNeedle);
+    }
+#endif
+#if defined(NUDGE_MATCHER_X86)
+    return matcher::asciiContains(matcher::Kernel::Sse2, haystack, lowerNeedle);
+#else
+    return matcher::asciiContains(matcher::Kernel::Scalar, haystack, lowerNeedle);
+#endif
+  }
+
+  // Simple one-to-one case folding for the scripts task text is most likely to use.
+  char32_t foldCodepoint(char32_t c) {
+    if (c < 0x80) return foldAscii(static_cast<unsigned char>(c));
+    if (c >= 0xC0 && c <= 0xDE && c != 0xD7) return c + 0x20;                 // Latin-1 Supplement
+    if (c >= 0x100 && c <= 0x137) return c | 1;                                // Latin Extended-A, even = upper
+    if (c >= 0x139 && c <= 0x148) return (c & 1) ? c + 1 : c;                  //   odd = upper here
+    if (c >= 0x14A && c <= 0x177) return c | 1;
+    if (c == 0x178) return 0xFF;
+    if (c >= 0x179 && c <= 0x17E) return (c & 1) ? c + 1 : c;
+    if (c >= 0x391 && c <= 0x3AB && c != 0x3A2) return c + 0x20;               // Greek
+    if (c >= 0x400 && c <= 0x40F) return c + 0x50;                             // Cyrillic
+    if (c >= 0x410 && c <= 0x42F) return c + 0x20;
+    return c;
+  }
+
+  // Decodes UTF-8 into folded code points. Invalid bytes map to themselves so
+  // malformed text still matches byte-for-byte.
+  std::u32string foldUtf8(std::string_view s) {
+    std::u32string out;
+    out.reserve(s.size());
+    for (std::size_t i = 0; i < s.size();) {
+      const auto c = static_cast<unsigned char>(s[i]);
+      std::size_t len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+      char32_t cp = len == 1 ? c : len == 2 ? (c & 0x1F) : len == 3 ? (c & 0x0F) : (c & 0x07);
+
+      bool valid = len != 0 && i + len <= s.size();
+      for (std::size_t k = 1; valid && k < len; k++) {
+        const auto cc = static_cast<unsigned char>(s[i + k]);
+        valid = (cc & 0xC0) == 0x80;
+        cp = (cp << 6) | (cc & 0x3F);
+      }
+
+      if (!valid) {
+        out.push_back(c);
+        i++;
+        continue;
+      }
+      out.push_back(foldCodepoint(cp));
+      i += len;
+    }
+    return out;
+  }
+
+  // A needle folded once, so a scan does not redo it for every row.
+  struct FoldedNeedle {
+    bool ascii;
+    std::string lower;       // when ascii
+    std::u32string folded;   // otherwise
+  };
+
+  FoldedNeedle foldNeedle(std::string_view needle) {
+    FoldedNeedle out{isAscii(needle), {}, {}};
+    if (out.ascii) {
+      out.lower.assign(needle);
+      for (char& c : out.lower) {
+        c = static_cast<char>(foldAscii(static_cast<unsigned char>(c)));
+      }
+    } else {
+      out.folded = foldUtf8(needle);
+    }
+    return out;
+  }
+
+  // `needle` is non-empty and no longer than `haystack`.
+  bool containsFolded(std::string_view haystack, const FoldedNeedle& needle) {
+    if (needle.ascii) {
+      // Non-ASCII haystack bytes can never equal an ASCII needle byte, so the
+      // byte-wise fast path is exact even when the task text itself is UTF-8.
+      return fastestAsciiContains(haystack, needle.lower);
+    }
+    return foldUtf8(haystack).find(needle.folded) != std::u32string::npos;
+  }
+
+  void containsFunction(sqlite3_context* ctx, int, sqlite3_value** argv) {
+    if (sqlite3_value_type(argv[0]) == SQLITE_NULL || sqlite3_value_type(argv[1]) == SQLITE_NULL) {
+      sqlite3_result_null(ctx);
+      return;
+    }
+
+    const auto* text = reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+    const std::string_view haystack(text ? text : "", static_cast<std::size_t>(sqlite3_value_bytes(argv[0])));
+
+    // The needle is almost always a bound parameter, constant for the whole
+    // statement; SQLite keeps its folded form between rows until it changes.
+    auto* needle = static_cast<FoldedNeedle*>(sqlite3_get_auxdata(ctx, 1));
+    if (!needle) {
+      const auto* raw = reinterpret_cast<const char*>(sqlite3_value_text(argv[1]));
+      needle = new FoldedNeedle(foldNeedle(std::string_view(raw ? raw : "",
+                                                            static_cast<std::size_t>(sqlite3_value_bytes(argv[1])))));
+      sqlite3_set_auxdata(ctx, 1, needle, [](void* p) { delete static_cast<FoldedNeedle*>(p); });
+      // set_auxdata may have freed it already when it could not keep it.
+      needle = static_cast<FoldedNeedle*>(sqlite3_get_auxdata(ctx, 1));
+      if (!needle) {
+        sqlite3_result_error_nomem(ctx);
+        return;
+      }
+    }
+
+    const std::size_t needleBytes = static_cast<std::size_t>(sqlite3_value_bytes(argv[1]));
+    const bool found = needleBytes == 0 || (needleBytes <= haystack.size() && containsFolded(haystack, *needle));
+    sqlite3_result_int(ctx, found ? 1 : 0);
+  }
+} // private namespace
+
+namespace matcher {
+  bool containsIgnoreCase(std::string_view haystack, std::string_view needle) {
+    if (needle.empty()) {
+      return true;
+    }
+    if (needle.size() > haystack.size()) {
+      return false;
+    }
+
+    return containsFolded(haystack, foldNeedle(needle));
+  }
+
+  bool kernelSupported(Kernel kernel) {
+    switch (kernel) {
+      case Kernel::Scalar:
+        return true;
+      case Kernel::Sse2:
+#if defined(NUDGE_MATCHER_X86)
+        return true;
+#else
+        return false;
+#endif
+      case Kernel::Avx2:
+#if defined(NUDGE_MATCHER_X86) && defined(__GNUC__)
+        return cpuHasAvx2();
+#else
+        return false;
+#endif
+    }
+    return false;
+  }
+
+  bool asciiContains(Kernel kernel, std::string_view haystack, std::string_view lowerNeedle) {
+    const auto* text = reinterpret_cast<const unsigned char*>(haystack.data());
+    const auto* needle = reinterpret_cast<const unsigned char*>(lowerNeedle.data());
+    const std::size_t m = lowerNeedle.size();
+    if (m > haystack.size()) {
+      return false;
+    }
+
+    switch (kernel) {
+#if defined(NUDGE_MATCHER_X86) && defined(__GNUC__)
+      case Kernel::Avx2:
+        return avx2Find(text, haystack.size(), needle, m) != std::string_view::npos;
+#endif
+#if defined(NUDGE_MATCHER_X86)
+      case Kernel::Sse2:
+        return sse2Find(text, haystack.size(), needle, m) != std::string_view::npos;
+#endif
+      default:
+        return scalarFind(text, haystack.size(), 0, needle, m) != std::string_view::npos;
+    }
+  }
+
+  int registerFunctions(sqlite3* db) {
+    return sqlite3_create_function_v2(db, "nudge_contains", 2, SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS,
+                                      nullptr, containsFunction, nullptr, nullptr, nullptr);
+  }
+} // matcher
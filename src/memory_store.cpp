@@ -0,0 +1,132 @@
+#include <ctime>
+#include <string>
+
+#include "matcher.hpp"
+#include "memory_store.hpp"
+
+namespace {
+  long long now() {
+    return static_cast<long long>(std::time(nullptr));
+  }
+} // private namespace
+
+Task* MemoryStore::pendingTask(long long id) {
+  if (id < 1 || static_cast<std::size_t>(id) > slots.size()) {
+    return nullptr;
+  }
+  auto& slot = slots[static_cast<std::size_t>(id - 1)];
+  return slot && slot->status == TaskStatus::Pending ? &*slot : nullptr;
+}
+
+void MemoryStore::complete(Task& task, long long when) {
+  task.status = TaskStatus::Completed;
+  task.completedAt = when;
+  pending--;
+}
+
+// Moves firstOpen past deleted and completed tasks; neither can become pending again.
+void MemoryStore::skipSettled() {
+  while (firstOpen < slots.size() && (!slots[firstOpen] || slots[firstOpen]->status != TaskStatus::Pending)) {
+    firstOpen++;
+  }
+}
+
+long long MemoryStore::add(std::string_view text) {
+  Task task;
+  task.id = static_cast<long long>(slots.size()) + 1;
+  task.text = std::string(text);
+  task.createdAt = now();
+  slots.emplace_back(std::move(task));
+  pending++;
+  return slots.back()->id;
+}
+
+bool MemoryStore::remove(long long id) {
+  if (!pendingTask(id)) {
+    return false;
+  }
+  slots[static_cast<std::size_t>(id - 1)].reset();
+  pending--;
+  return true;
+}
+
+std::optional<Task> MemoryStore::completeById(long long id) {
+  Task* task = pendingTask(id);
+  if (!task) {
+    return std::nullopt;
+  }
+  complete(*task, now());
+  return *task;
+}
+
+long long MemoryStore::completeByIds(std::span<const long long> ids, const TaskVisitor& visit) {
+  const long long when = now();
+  long long completed = 0;
+  for (long long id : ids) {
+    if (Task* task = pendingTask(id)) {
+      complete(*task, when);
+      visit(*task);
+      completed++;
+    }
+  }
+  return completed;
+}
+
+long long MemoryStore::completeMatching(std::string_view pattern, const TaskVisitor& visit) {
+  skipSettled();
+  const long long when = now();
+  long long completed = 0;
+  for (std::size_t i = firstOpen; i < slots.size(); i++) {
+    auto& slot = slots[i];
+    if (slot && slot->status == TaskStatus::Pending && matcher::containsIgnoreCase(slot->text, pattern)) {
+      complete(*slot, when);
+      visit(*slot);
+      completed++;
+    }
+  }
+  return completed;
+}
+
+long long MemoryStore::completeOlderThan(long long seconds, const TaskVisitor& visit) {
+  skipSettled();
+  const long long when = now();
+  long long completed = 0;
+  // Tasks are created in id order, so the scan stops at the first one that is too new.
+  for (std::size_t i = firstOpen; i < slots.size(); i++) {
+    auto& slot = slots[i];
+    if (!slot) {
+      continue;
+    }
+    if (slot->createdAt >= when - seconds) {
+      break;
+    }
+    if (slot->status == TaskStatus::Pending) {
+      complete(*slot, when);
+      visit(*slot);
+      completed++;
+    }
+  }
+  return completed;
+}
+
+std::optional<Task> MemoryStore::firstPending() {
+  skipSettled();
+  if (firstOpen == slots.size()) {
+    return std::nullopt;
+  }
+  return *slots[firstOpen];
+}
+
+void MemoryStore::forEachPending(const TaskVisitor& visit) {
+  skipSettled();
+  for (std::size_t i = slots.size(); i > firstOpen; i--) {
+    const auto& slot = slots[i - 1];
+    if (slot && slot->status == TaskStatus::Pending) {
+      visit(*slot);
+    }
+  }
+}
+
+long long MemoryStore::countPending() {
+  return pending;
+}
@@ -1,5 +1,6 @@
 #include <filesystem>
 #include <print>
+#include <string>
 
 #include "paths.hpp"
 
@@ -14,4 +15,58 @@ namespace Paths {
 
     return { home };
   }
+
+  const std::filesystem::path& configDirectoryPath() {
+    static const auto path = getHome() / conifgDirectoryName;
+    return path;
+  }
+
+  const std::filesystem::path& dbPath() {
+    static const auto path = configDirectoryPath() / dbName;
+    return path;
+  }
+
+  const std::filesystem::path& socketPath() {
+    static const auto path = configDirectoryPath() / socketName;
+    return path;
+  }
+
+  const std::filesystem::path& configPath() {
+    static const auto path = configDirectoryPath() / configName;
+    return path;
+  }
+
+  const std::filesystem::path& archiveDirectoryPath() {
+    static const auto path = configDirectoryPath() / archiveDirectoryName;
+    return path;
+  }
+
+  const std::filesystem::path& backupDirectoryPath() {
+    static const auto path = configDirectoryPath() / backupDirectoryName;
+    return path;
+  }
+
+  const std::filesystem::path& logPath() {
+    static const auto path = configDirectoryPath() / logName;
+    return path;
+  }
+
+  const std::filesystem::path& logIndexPath() {
+    static const auto path = configDirectoryPath() / logIndexName;
+    return path;
+  }
+
+  const std::filesystem::path& logLockPath() {
+    static const auto path = configDirectoryPath() / logLockName;
+    return path;
+  }
+
+  const std::filesystem::path& storesPath() {
+    static const auto path = configDirectoryPath() / storesName;
+    return path;
+  }
+
+  std::filesystem::path archivePath(int year) {
+    return archiveDirectoryPath() / (std::to_string(year) + ".db");
+  }
 }
@@ -0,0 +1,331 @@
+#include <print>
+#include <format>
+#include <string>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <csignal>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "paths.hpp"
+#include "flags.hpp"
+#include "server.hpp"
+#include "database.hpp"
+#include "settings.hpp"
+
+namespace {
+  constexpr std::uint8_t PROTOCOL_MAGIC = 'N';
+  constexpr std::uint8_t PROTOCOL_VERSION = 2;
+  constexpr std::uint32_t MAX_DESCRIPTION_LENGTH = 1 << 20;
+  // Reply when the daemon will not run a request; the client then runs it itself.
+  constexpr std::uint8_t STATUS_DECLINED = 0xFF;
+  // A client that stalls mid-request must not block everyone else.
+  constexpr int CLIENT_TIMEOUT_SECONDS = 5;
+
+#if defined(MSG_NOSIGNAL)
+  constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+  constexpr int SEND_FLAGS = 0;
+#endif
+
+  struct RequestHeader {
+    std::uint8_t magic;
+    std::uint8_t version;
+    std::uint8_t flag;
+    std::uint8_t reserved;
+    std::uint32_t length;
+    std::uint64_t settings; // settingsHash() of the client
+  };
+
+  volatile std::sig_atomic_t stopRequested = 0;
+
+  void requestStop(int) {
+    stopRequested = 1;
+  }
+
+  // Closes the descriptor when it goes out of scope.
+  struct FileDescriptor {
+    int fd = -1;
+
+    explicit FileDescriptor(int fd) : fd(fd) {}
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    ~FileDescriptor() {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  };
+
+  int unixSocket() {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0) {
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+#if defined(SO_NOSIGPIPE)
+      int on = 1;
+      setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    }
+    return fd;
+  }
+
+  bool socketAddress(sockaddr_un& addr) {
+    const std::string path = Paths::socketPath().string();
+    if (path.size() >= sizeof(addr.sun_path)) {
+      return false;
+    }
+
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+  }
+
+  // FNV-1a of settings::fingerprint(). The daemon only runs commands from
+  // clients that resolved the same config and NUDGE_* overrides it did.
+  std::uint64_t settingsHash() {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : settings::fingerprint(settings::current())) {
+      hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return hash;
+  }
+
+  // Only the user who started the daemon may talk to it.
+  bool peerIsOwner(int fd) {
+#if defined(SO_PEERCRED)
+    ucred peer{};
+    socklen_t size = sizeof(peer);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &size) == 0 && peer.uid == geteuid();
+#else
+    uid_t uid = 0;
+    gid_t gid = 0;
+    return getpeereid(fd, &uid, &gid) == 0 && uid == geteuid();
+#endif
+  }
+
+  bool readExactly(int fd, void* buffer, std::size_t size) {
+    auto* out = static_cast<char*>(buffer);
+    while (size > 0) {
+      ssize_t n = read(fd, out, size);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return false;
+      }
+      out += n;
+      size -= static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+
+  bool writeExactly(int fd, const void* buffer, std::size_t size) {
+    const auto* in = static_cast<const char*>(buffer);
+    while (size > 0) {
+      ssize_t n = send(fd, in, size, SEND_FLAGS);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return false;
+      }
+      in += n;
+      size -= static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+
+  // Commands that read the caller's stdin, resolve paths against its working
+  // directory or start programs in its environment (notify) cannot run in the
+  // daemon; the CLI runs them itself.
+  bool runsInCaller(Flag flag) {
+    return flag == Flag::DAEMON || flag == Flag::ERROR || flag == Flag::IMPORT || flag == Flag::NOTIFY
+        || flag == Flag::BACKUP || flag == Flag::RESTORE || flag == Flag::STORE || flag == Flag::FEDERATED;
+  }
+
+  // Runs `pc` with the process's stdout and stderr temporarily pointing at the client's.
+
+  bool executeWithOutput(Database& db, const ParsedCommand& pc, int out, int err) {
+    std::fflush(stdout);
+    std::fflush(stderr);
+    FileDescriptor savedOut(dup(STDOUT_FILENO));
+    FileDescriptor savedErr(dup(STDERR_FILENO));
+    dup2(out, STDOUT_FILENO);
+    dup2(err, STDERR_FILENO);
+
+    bool ok = executeCommand(db, pc);
+
+    std::fflush(stdout);
+    std::fflush(stderr);
+    dup2(savedOut.fd, STDOUT_FILENO);
+    dup2(savedErr.fd, STDERR_FILENO);
+    return ok;
+  }
+
+  void serveClient(Database& db, int client) {
+    RequestHeader header{};
+    int passed[2] = {-1, -1};
+
+    iovec iov{&header, sizeof(header)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(passed))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n = recvmsg(client, &msg, MSG_WAITALL);
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+          cmsg->cmsg_len == CMSG_LEN(sizeof(passed))) {
+        std::memcpy(passed, CMSG_DATA(cmsg), sizeof(passed));
+      }
+    }
+    FileDescriptor out(passed[0]);
+    FileDescriptor err(passed[1]);
+
+    std::uint8_t status = 1;
+    const bool valid = n == static_cast<ssize_t>(sizeof(header)) && header.magic == PROTOCOL_MAGIC &&
+        header.version == PROTOCOL_VERSION && header.flag < static_cast<std::uint8_t>(Flag::ERROR) &&
+        header.length <= MAX_DESCRIPTION_LENGTH && out.fd >= 0 && err.fd >= 0;
+    if (valid && (runsInCaller(static_cast<Flag>(header.flag)) || header.settings != settingsHash())) {
+      status = STATUS_DECLINED;
+    } else if (valid) {
+      ParsedCommand pc{static_cast<Flag>(header.flag), std::string(header.length, '\0')};
+      if (readExactly(client, pc.description.data(), header.length)) {
+        status = executeWithOutput(db, pc, out.fd, err.fd) ? 0 : 1;
+      }
+    }
+
+    writeExactly(client, &status, sizeof(status));
+  }
+} // private namespace
+
+namespace server {
+
+  std::optional<int> forward(const ParsedCommand& pc) {
+    sockaddr_un addr;
+    // NUDGE_READ_MODE picks how this process opens the file, which a daemon session cannot honour.
+    if (runsInCaller(pc.flag) || pc.description.size() > MAX_DESCRIPTION_LENGTH || std::getenv("NUDGE_READ_MODE") ||
+        !socketAddress(addr)) {
+      return std::nullopt;
+    }
+
+    FileDescriptor sock(unixSocket());
+    if (sock.fd < 0 || connect(sock.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      return std::nullopt;
+    }
+
+    RequestHeader header{PROTOCOL_MAGIC, PROTOCOL_VERSION, static_cast<std::uint8_t>(pc.flag), 0,
+                         static_cast<std::uint32_t>(pc.description.size()), settingsHash()};
+    int passed[2] = {STDOUT_FILENO, STDERR_FILENO};
+
+    iovec iov{&header, sizeof(header)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(passed))];
+    std::memset(control, 0, sizeof(control));
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(passed));
+    std::memcpy(CMSG_DATA(cmsg), passed, sizeof(passed));
+
+    std::fflush(stdout);
+    if (sendmsg(sock.fd, &msg, SEND_FLAGS) != static_cast<ssize_t>(sizeof(header)) ||
+        !writeExactly(sock.fd, pc.description.data(), pc.description.size())) {
+      // Nothing reached the daemon, so running the command locally is still safe.
+      return std::nullopt;
+    }
+
+    std::uint8_t status = 1;
+    if (!readExactly(sock.fd, &status, sizeof(status))) {
+      std::println(stderr, "Warning: nudged closed the connection before confirming the command.");
+    } else if (status == STATUS_DECLINED) {
+      // The daemon ran nothing (e.g. its settings differ from ours).
+      return std::nullopt;
+    }
+    return status;
+  }
+
+  int run(Database& db) {
+    sockaddr_un addr;
+    if (!socketAddress(addr)) {
+      std::println(stderr, "Socket path too long: {}", Paths::socketPath().string());
+      return 1;
+    }
+
+    FileDescriptor probe(unixSocket());
+    if (probe.fd >= 0 && connect(probe.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+      std::println(stderr, "nudged is already running on {}", Paths::socketPath().string());
+      return 1;
+    }
+
+    // Nobody is listening, so any socket file left behind is stale.
+    std::error_code ec;
+    std::filesystem::remove(Paths::socketPath(), ec);
+
+    // The socket file is created owner-only by bind() itself; chmod afterwards
+    // would leave a window in which anyone could connect.
+    FileDescriptor listener(unixSocket());
+    const mode_t previousMask = umask(S_IRWXG | S_IRWXO | S_IXUSR);
+    const bool bound = listener.fd >= 0 && bind(listener.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    const int bindError = errno;
+    umask(previousMask);
+    if (!bound || listen(listener.fd, SOMAXCONN) != 0) {
+      std::println(stderr, "Failed to listen on {}: {}", Paths::socketPath().string(),
+                   std::strerror(bound ? errno : bindError));
+      return 1;
+    }
+
+    // No SA_RESTART: a signal must interrupt accept() so the loop can exit.
+    struct sigaction action{};
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::println("nudged listening on {}", Paths::socketPath().string());
+    std::fflush(stdout);
+
+    while (!stopRequested) {
+      int client = accept(listener.fd, nullptr, nullptr);
+      if (client < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+        std::println(stderr, "accept failed: {}", std::strerror(errno));
+        break;
+      }
+
+      FileDescriptor connection(client);
+      fcntl(connection.fd, F_SETFD, FD_CLOEXEC);
+      if (!peerIsOwner(connection.fd)) {
+        continue;
+      }
+
+      timeval timeout{CLIENT_TIMEOUT_SECONDS, 0};
+      setsockopt(connection.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      setsockopt(connection.fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+      serveClient(db, connection.fd);
+    }
+
+    std::filesystem::remove(Paths::socketPath(), ec);
+    return 0;
+  }
+} // server
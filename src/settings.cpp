@@ -0,0 +1,260 @@
+#include <print>
+#include <format>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <utility>
+#include <charconv>
+#include <optional>
+
+#include "flags.hpp"
+#include "paths.hpp"
+#include "settings.hpp"
+
+namespace {
+  std::string trim(std::string_view s) {
+    const auto first = s.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) {
+      return "";
+    }
+    const auto last = s.find_last_not_of(" \t\r");
+    return std::string(s.substr(first, last - first + 1));
+  }
+
+  template <typename T>
+  std::optional<T> parseNumber(const std::string& value) {
+    T result{};
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (ec != std::errc() || end != value.data() + value.size()) {
+      return std::nullopt;
+    }
+    return result;
+  }
+
+  std::optional<Synchronous> parseSynchronous(std::string value) {
+    lower(value);
+    if (value == "off" || value == "0") return Synchronous::Off;
+    if (value == "normal" || value == "1") return Synchronous::Normal;
+    if (value == "full" || value == "2") return Synchronous::Full;
+    return std::nullopt;
+  }
+
+  std::optional<TempStore> parseTempStore(std::string value) {
+    lower(value);
+    if (value == "default" || value == "0") return TempStore::Default;
+    if (value == "file" || value == "1") return TempStore::File;
+    if (value == "memory" || value == "2") return TempStore::Memory;
+    return std::nullopt;
+  }
+
+  std::optional<AutoVacuum> parseAutoVacuum(std::string value) {
+    lower(value);
+    if (value == "none" || value == "0") return AutoVacuum::None;
+    if (value == "incremental" || value == "2") return AutoVacuum::Incremental;
+    return std::nullopt;
+  }
+
+  std::optional<Backend> parseBackend(std::string value) {
+    lower(value);
+    if (value == "sqlite") return Backend::Sqlite;
+    if (value == "log") return Backend::Log;
+    return std::nullopt;
+  }
+
+  std::optional<bool> parseSwitch(std::string value) {
+    lower(value);
+    if (value == "on" || value == "true" || value == "yes" || value == "1") return true;
+    if (value == "off" || value == "false" || value == "no" || value == "0") return false;
+    return std::nullopt;
+  }
+
+  // Named profiles. "small" matches SQLite's defaults for a modest todo list;
+  // "large-archive" suits multi-million-row histories: a 256 MiB page cache,
+  // 1 GiB of mmap, 16 KiB pages and in-memory sorts.
+  bool applyPreset(Settings& settings, std::string name) {
+    lower(name);
+    if (name == "small") {
+      settings.cacheSize = -2000;
+      settings.mmapSize = 0;
+      settings.pageSize = 4096;
+      settings.tempStore = TempStore::Default;
+    } else if (name == "large-archive") {
+      settings.cacheSize = -262144;
+      settings.mmapSize = 1LL << 30;
+      settings.pageSize = 16384;
+      settings.tempStore = TempStore::Memory;
+    } else {
+      return false;
+    }
+    settings.preset = name;
+    return true;
+  }
+
+  void warnInvalid(const std::string& key, const std::string& value) {
+    std::println(stderr, "{}: ignoring invalid value '{}' for '{}'.", Paths::configPath().string(), value, key);
+  }
+
+  void applyOption(Settings& settings, const std::string& key, const std::string& value) {
+    if (key == "synchronous") {
+      if (auto level = parseSynchronous(value)) settings.synchronous = *level;
+      else warnInvalid(key, value);
+    } else if (key == "cache_size") {
+      if (auto size = parseNumber<int>(value)) settings.cacheSize = *size;
+      else warnInvalid(key, value);
+    } else if (key == "mmap_size") {
+      if (auto size = parseNumber<long long>(value); size && *size >= 0) settings.mmapSize = *size;
+      else warnInvalid(key, value);
+    } else if (key == "page_size") {
+      auto size = parseNumber<int>(value);
+      if (size && *size >= 512 && *size <= 65536 && (*size & (*size - 1)) == 0) settings.pageSize = *size;
+      else warnInvalid(key, value);
+    } else if (key == "temp_store") {
+      if (auto store = parseTempStore(value)) settings.tempStore = *store;
+      else warnInvalid(key, value);
+    } else if (key == "auto_vacuum") {
+      if (auto mode = parseAutoVacuum(value)) settings.autoVacuum = *mode;
+      else warnInvalid(key, value);
+    } else if (key == "in_memory") {
+      if (auto enabled = parseSwitch(value)) settings.inMemory = *enabled;
+      else warnInvalid(key, value);
+    } else if (key == "backend") {
+      if (auto backend = parseBackend(value)) settings.backend = *backend;
+      else warnInvalid(key, value);
+    } else {
+      std::println(stderr, "{}: ignoring unknown setting '{}'.", Paths::configPath().string(), key);
+    }
+  }
+
+  void loadConfigFile(Settings& settings) {
+    std::ifstream file(Paths::configPath());
+    if (!file) {
+      return;
+    }
+    settings.configLoaded = true;
+
+    std::vector<std::pair<std::string, std::string>> options;
+    std::string line;
+    while (std::getline(file, line)) {
+      line = trim(line.substr(0, line.find('#')));
+      if (line.empty()) {
+        continue;
+      }
+
+      const auto eq = line.find('=');
+      if (eq == std::string::npos) {
+        std::println(stderr, "{}: ignoring malformed line '{}'.", Paths::configPath().string(), line);
+        continue;
+      }
+
+      std::string key = trim(std::string_view(line).substr(0, eq));
+      lower(key);
+      options.emplace_back(std::move(key), trim(std::string_view(line).substr(eq + 1)));
+    }
+
+    // The preset goes first wherever it appears, so explicit keys always override it.
+    for (const auto& [key, value] : options) {
+      if (key == "preset" && !applyPreset(settings, value)) {
+        std::println(stderr, "{}: unknown preset '{}' (expected small or large-archive).",
+                     Paths::configPath().string(), value);
+      }
+    }
+    for (const auto& [key, value] : options) {
+      if (key != "preset") {
+        applyOption(settings, key, value);
+      }
+    }
+  }
+
+  Settings load() {
+    Settings settings;
+    loadConfigFile(settings);
+
+    if (const char* value = std::getenv("NUDGE_SYNCHRONOUS")) {
+      if (auto level = parseSynchronous(value)) {
+        settings.synchronous = *level;
+      } else {
+        std::println(stderr, "Ignoring NUDGE_SYNCHRONOUS='{}': expected off, normal or full.", value);
+      }
+    }
+
+    if (const char* value = std::getenv("NUDGE_IN_MEMORY")) {
+      if (auto enabled = parseSwitch(value)) {
+        settings.inMemory = *enabled;
+      } else {
+        std::println(stderr, "Ignoring NUDGE_IN_MEMORY='{}': expected on or off.", value);
+      }
+    }
+
+    if (const char* value = std::getenv("NUDGE_BACKEND")) {
+      if (auto backend = parseBackend(value)) {
+        settings.backend = *backend;
+      } else {
+        std::println(stderr, "Ignoring NUDGE_BACKEND='{}': expected sqlite or log.", value);
+      }
+    }
+
+    return settings;
+  }
+} // private namespace
+
+namespace settings {
+  const Settings& current() {
+    static const Settings settings = load();
+    return settings;
+  }
+
+  std::string fingerprint(const Settings& settings) {
+    return std::format("synchronous={} cache_size={} mmap_size={} page_size={} temp_store={} auto_vacuum={} in_memory={} backend={}",
+                       name(settings.synchronous),
+                       settings.cacheSize ? std::to_string(*settings.cacheSize) : "-",
+                       settings.mmapSize ? std::to_string(*settings.mmapSize) : "-",
+                       settings.pageSize ? std::to_string(*settings.pageSize) : "-",
+                       settings.tempStore ? name(*settings.tempStore) : "-",
+                       name(settings.autoVacuum), settings.inMemory ? "on" : "off", name(settings.backend));
+  }
+
+  std::string_view name(Synchronous level) {
+    switch (level) {
+      case Synchronous::Off:
+        return "OFF";
+      case Synchronous::Normal:
+        return "NORMAL";
+      case Synchronous::Full:
+        return "FULL";
+    }
+    return "NORMAL";
+  }
+
+  std::string_view name(TempStore store) {
+    switch (store) {
+      case TempStore::Default:
+        return "DEFAULT";
+      case TempStore::File:
+        return "FILE";
+      case TempStore::Memory:
+        return "MEMORY";
+    }
+    return "DEFAULT";
+  }
+
+  std::string_view name(AutoVacuum mode) {
+    switch (mode) {
+      case AutoVacuum::None:
+        return "NONE";
+      case AutoVacuum::Incremental:
+        return "INCREMENTAL";
+    }
+    return "NONE";
+  }
+
+  std::string_view name(Backend backend) {
+    switch (backend) {
+      case Backend::Sqlite:
+        return "sqlite";
+      case Backend::Log:
+        return "log";
+    }
+    return "sqlite";
+  }
+} // settings
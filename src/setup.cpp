@@ -1,20 +1,17 @@
 #include <filesystem>
+#include <cstdlib>
 #include <cstdio>
 #include <print>
+#include <string_view>
 
 #include "setup.hpp"
 #include "paths.hpp"
 #include "sqlite3.h"
 #include "database.hpp"
+#include "settings.hpp"
 
 
 namespace {
-   enum class SetupStatus {
-    Uninitialized,
-    DbAbsent,
-    Complete,
-  };
-
   void checkOS () {
     #if defined (__APPLE__) || defined (__linux__) 
       return;
@@ -24,42 +21,75 @@ namespace {
     #endif
   }
 
-  SetupStatus getSetupStatus() {
-    if (!std::filesystem::is_directory(Paths::configDirectoryPath)) {
-      return SetupStatus::Uninitialized;
+  // Listing, counting and searching never write, so they get a read-only connection.
+  // NUDGE_READ_MODE=immutable|nolock opens read-only commands on snapshot files
+  // without any locking.
+  Access requiredAccess(const ParsedCommand& pc) {
+    switch (pc.flag) {
+      case Flag::LIST_ALL:
+      case Flag::LIST_PENDING:
+      case Flag::SHOW_COMPLETE_TASKS:
+      case Flag::NOTIFY:
+      case Flag::SEARCH:
+      case Flag::EXPORT:
+      case Flag::FEDERATED:
+        break;
+      default:
+        return Access::ReadWrite;
     }
 
-    if (!std::filesystem::is_regular_file(Paths::dbPath)) {
-      return SetupStatus::DbAbsent;
+    const char* mode = std::getenv("NUDGE_READ_MODE");
+    if (mode && std::string_view(mode) == "immutable") {
+      return Access::Immutable;
     }
+    if (mode && std::string_view(mode) == "nolock") {
+      return Access::NoLock;
+    }
+    return Access::ReadOnly;
+  }
 
-    return SetupStatus::Complete;
+  // in_memory / NUDGE_IN_MEMORY loads the database into memory for one command.
+  // The daemon keeps its session for hours, so it always works on the file.
+  bool loadsIntoMemory(const ParsedCommand& pc) {
+    return settings::current().inMemory && pc.flag != Flag::DAEMON;
   }
 
-  void setupEnvironment(SetupStatus setupStatus) {
-    switch (setupStatus) {
-      case SetupStatus::Uninitialized :
-        std::filesystem::create_directory(Paths::configDirectoryPath);
-        database::openDatabase();
-        break;
-      case SetupStatus::DbAbsent:
-        database::openDatabase();
-        break;
-      default:
-        break;
+  // The config directory exists on every run but the first, so open straight away
+  // and only create it when SQLite reports that the file cannot be opened.
+  Database openSession(bool inMemory) {
+    try {
+      return Database(Access::ReadWrite, inMemory);
+    } catch (const DatabaseException&) {
+      std::filesystem::create_directories(Paths::configDirectoryPath());
+      return Database(Access::ReadWrite, inMemory);
     }
   }
 
 } // private namespace
 
-void initializeApplication() {
+Database initializeApplication(const ParsedCommand& pc) {
   checkOS();
-  const SetupStatus setupStatus = getSetupStatus();
 
-  if (setupStatus != SetupStatus::Complete) {
-    setupEnvironment(setupStatus);
+  const Access access = requiredAccess(pc);
+  if (access != Access::ReadWrite) {
+    try {
+      Database db(access, loadsIntoMemory(pc));
+      if (database::schemaVersion(db) == Queries::SCHEMA_VERSION) {
+        return db;
+      }
+    } catch (const DatabaseException&) {
+      // Missing or unreadable: fall through to a read-write session that creates it.
+    }
   }
 
-  database::setupTables();
+  // The session opened here is the only connection the command uses; opening it
+  // also creates the database file when it is absent.
+  Database db = openSession(loadsIntoMemory(pc));
+  try {
+    database::setupTables(db);
+  } catch (const DatabaseException& e) {
+    std::println(stderr, "DB Error setting up tables: {}", e.what());
+    std::exit(1);
+  }
+  return db;
 }
-
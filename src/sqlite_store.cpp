@@ -0,0 +1,112 @@
+#include <format>
+#include <string>
+
+#include "sqlite3.h"
+#include "database.hpp"
+#include "sqlite_store.hpp"
+
+namespace {
+  // Rows are (id, task, created_at[, completed_at]).
+  Task readTask(sqlite3_stmt* stmt, TaskStatus status) {
+    Task task;
+    task.id = sqlite3_column_int64(stmt, 0);
+    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    task.text = text ? text : "";
+    task.status = status;
+    task.createdAt = sqlite3_column_int64(stmt, 2);
+    if (sqlite3_column_count(stmt) > 3 && sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
+      task.completedAt = sqlite3_column_int64(stmt, 3);
+    }
+    return task;
+  }
+
+  long long visitRows(Database& db, StatementCache::Lease& stmt, TaskStatus status, const TaskVisitor& visit) {
+    long long rows = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+      rows++;
+      visit(readTask(stmt.get(), status));
+    }
+
+    if (rc != SQLITE_DONE) {
+      throw DatabaseException(std::format("Error stepping through results (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+    }
+    return rows;
+  }
+} // private namespace
+
+long long SqliteStore::add(std::string_view text) {
+  auto stmt = db.prepare(Queries::INSERT_TASK_QUERY);
+  sqlite3_bind_text(stmt.get(), 1, text.data(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+  int rc = sqlite3_step(stmt.get());
+  if (rc != SQLITE_DONE) {
+    throw DatabaseException(std::format("Execution failed (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+  }
+  return sqlite3_last_insert_rowid(db.get());
+}
+
+bool SqliteStore::remove(long long id) {
+  auto stmt = db.prepare(Queries::DELETE_TASK_QUERY);
+  sqlite3_bind_int64(stmt.get(), 1, id);
+  int rc = sqlite3_step(stmt.get());
+  if (rc != SQLITE_DONE) {
+    throw DatabaseException(std::format("Execution failed (code: {}): {}", rc, sqlite3_errmsg(db.get())));
+  }
+  return sqlite3_changes(db.get()) > 0;
+}
+
+std::optional<Task> SqliteStore::completeById(long long id) {
+  auto stmt = db.prepare(Queries::COMPLETE_TASK_BY_ID_QUERY);
+  sqlite3_bind_int64(stmt.get(), 1, id);
+  std::optional<Task> completed;
+  visitRows(db, stmt, TaskStatus::Completed, [&](const Task& task) { completed = task; });
+  return completed;
+}
+
+long long SqliteStore::completeByIds(std::span<const long long> ids, const TaskVisitor& visit) {
+  // The ids go in as one JSON array for json_each(), so any number of them is a single statement.
+  std::string json = "[";
+  for (long long id : ids) {
+    if (json.size() > 1) {
+      json.push_back(',');
+    }
+    json += std::to_string(id);
+  }
+  json.push_back(']');
+
+  auto stmt = db.prepare(Queries::COMPLETE_TASKS_BY_IDS_QUERY);
+  sqlite3_bind_text(stmt.get(), 1, json.c_str(), static_cast<int>(json.size()), SQLITE_TRANSIENT);
+  return visitRows(db, stmt, TaskStatus::Completed, visit);
+}
+
+long long SqliteStore::completeMatching(std::string_view pattern, const TaskVisitor& visit) {
+  auto stmt = db.prepare(Queries::COMPLETE_TASKS_MATCHING_QUERY);
+  sqlite3_bind_text(stmt.get(), 1, pattern.data(), static_cast<int>(pattern.size()), SQLITE_TRANSIENT);
+  return visitRows(db, stmt, TaskStatus::Completed, visit);
+}
+
+long long SqliteStore::completeOlderThan(long long seconds, const TaskVisitor& visit) {
+  auto stmt = db.prepare(Queries::COMPLETE_TASKS_OLDER_THAN_QUERY);
+  sqlite3_bind_int64(stmt.get(), 1, seconds);
+  return visitRows(db, stmt, TaskStatus::Completed, visit);
+}
+
+std::optional<Task> SqliteStore::firstPending() {
+  auto stmt = db.prepare(Queries::SELECT_FIRST_PENDING_TASK_QUERY);
+  std::optional<Task> first;
+  visitRows(db, stmt, TaskStatus::Pending, [&](const Task& task) { first = task; });
+  return first;
+}
+
+void SqliteStore::forEachPending(const TaskVisitor& visit) {
+  auto stmt = db.prepare(Queries::SELECT_ALL_TASKS_QUERY);
+  visitRows(db, stmt, TaskStatus::Pending, visit);
+}
+
+long long SqliteStore::countPending() {
+  auto stmt = db.prepare(Queries::COUNT_PENDING_TASKS_QUERY);
+  if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+    throw DatabaseException(std::format("Error counting pending tasks: {}", sqlite3_errmsg(db.get())));
+  }
+  return sqlite3_column_int64(stmt.get(), 0);
+}
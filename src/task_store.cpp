@@ -0,0 +1,14 @@
+#include <memory>
+
+#include "settings.hpp"
+#include "database.hpp"
+#include "task_store.hpp"
+#include "sqlite_store.hpp"
+#include "log_store.hpp"
+
+std::unique_ptr<TaskStore> openTaskStore(Database& db) {
+  if (settings::current().backend == Backend::Log) {
+    return std::make_unique<LogStore>(db.access());
+  }
+  return std::make_unique<SqliteStore>(db);
+}
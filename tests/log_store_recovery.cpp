@@ -0,0 +1,307 @@
+// Crash recovery, compaction and read-only opens of LogStore. A crash can
+// leave tasks.idx with slots that are newer than its header, or with a header
+// that lags the log, and can leave a torn record at the end of tasks.log;
+// opening the store again, for writing or reading, must give the same tasks
+// and counts as the log's whole records say. Compaction must keep ids from
+// being reused and completion times intact.
+//
+// HOME points at a scratch directory; each case starts from empty files.
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <iterator>
+#include <filesystem>
+#include <string_view>
+
+#include "paths.hpp"
+#include "log_store.hpp"
+#include "test_support.hpp"
+
+namespace {
+  std::string readFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  }
+
+  // Puts an earlier header back in front of the current slots, as a crash
+  // after commit() synced the slots but before it stored the header would.
+  void restoreHeader(const std::string& saved) {
+    std::fstream index(Paths::logIndexPath(), std::ios::binary | std::ios::in | std::ios::out);
+    index.write(saved.data(), sizeof(LogStore::Header));
+  }
+
+  void appendToLog(const std::string& bytes) {
+    std::ofstream log(Paths::logPath(), std::ios::binary | std::ios::app);
+    log.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  }
+
+  template <typename T>
+  void put(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+  }
+
+  // The index slot of `id`, read from tasks.idx.
+  LogStore::Slot slotOf(long long id) {
+    const std::string index = readFile(Paths::logIndexPath());
+    LogStore::Slot slot{};
+    const std::size_t at = sizeof(LogStore::Header) + static_cast<std::size_t>(id - 1) * sizeof(LogStore::Slot);
+    if (at + sizeof(slot) <= index.size()) {
+      std::memcpy(&slot, index.data() + at, sizeof(slot));
+    }
+    return slot;
+  }
+
+  long long countedPending(LogStore& store) {
+    long long listed = 0;
+    store.forEachPending([&](const Task&) { listed++; });
+    return listed;
+  }
+
+  void slotsAheadOfHeaderAfterAdd() {
+    std::string saved;
+    {
+      LogStore store;
+      store.add("a");
+      saved = readFile(Paths::logIndexPath());
+      store.add("b");
+    }
+    restoreHeader(saved);
+
+    LogStore store;
+    CHECK(store.countPending() == 2);
+    CHECK(countedPending(store) == 2);
+    CHECK(store.completeById(1).has_value());
+    CHECK(store.completeById(2).has_value());
+    CHECK(store.countPending() == 0);
+  }
+
+  void slotsAheadOfHeaderAfterComplete() {
+    std::string saved;
+    {
+      LogStore store;
+      store.add("a");
+      store.add("b");
+      saved = readFile(Paths::logIndexPath());
+      CHECK(store.completeById(1).has_value());
+    }
+    restoreHeader(saved);
+
+    LogStore store;
+    CHECK(store.countPending() == 1);
+    CHECK(countedPending(store) == 1);
+    CHECK(!store.completeById(1).has_value());
+  }
+
+  void slotsAheadOfHeaderAfterDelete() {
+    std::string saved;
+    {
+      LogStore store;
+      store.add("a");
+      store.add("b");
+      saved = readFile(Paths::logIndexPath());
+      CHECK(store.remove(2));
+    }
+    restoreHeader(saved);
+
+    LogStore store;
+    CHECK(store.countPending() == 1);
+    CHECK(countedPending(store) == 1);
+    store.add("c");
+    CHECK(store.countPending() == 2);
+  }
+
+  void lostIndexIsRebuilt() {
+    {
+      LogStore store;
+      store.add("a");
+      store.add("b");
+      store.add("c");
+      CHECK(store.completeById(2).has_value());
+      CHECK(store.remove(3));
+    }
+    std::filesystem::remove(Paths::logIndexPath());
+
+    LogStore store;
+    CHECK(store.countPending() == 1);
+    const auto first = store.firstPending();
+    CHECK(first && first->id == 1 && first->text == "a");
+    CHECK(store.add("d") == 4);
+  }
+
+  void readOnlyStoresShareTheLock() {
+    {
+      LogStore store;
+      store.add("a");
+    }
+    // Each store has its own lock file descriptor, so an exclusive lock here
+    // would block the second open forever.
+    LogStore first(Access::ReadOnly);
+    LogStore second(Access::ReadOnly);
+    CHECK(first.countPending() == 1);
+    CHECK(second.countPending() == 1);
+
+    bool refused = false;
+    try {
+      first.add("b");
+    } catch (const DatabaseException&) {
+      refused = true;
+    }
+    CHECK(refused);
+    CHECK(!first.remove(2));
+    CHECK(second.countPending() == 1);
+  }
+
+  void readOnlyOpenBringsTheIndexUpToDate() {
+    std::string saved;
+    {
+      LogStore store;
+      store.add("a");
+      saved = readFile(Paths::logIndexPath());
+      store.add("b");
+    }
+    restoreHeader(saved);
+
+    {
+      LogStore store(Access::ReadOnly);
+      CHECK(store.countPending() == 2);
+      CHECK(countedPending(store) == 2);
+    }
+    LogStore store(Access::ReadOnly);
+    CHECK(store.countPending() == 2);
+  }
+
+  // A write cut short: a frame header promising more payload than follows.
+  void partialFrameIsTruncated() {
+    {
+      LogStore store;
+      store.add("a");
+      store.add("b");
+      CHECK(store.completeById(1).has_value());
+    }
+    const auto whole = std::filesystem::file_size(Paths::logPath());
+    std::string torn;
+    put<std::uint32_t>(torn, 0x12345678);
+    put<std::uint32_t>(torn, 40);
+    torn += "\x01partial";
+    appendToLog(torn);
+
+    {
+      LogStore store;
+      CHECK(std::filesystem::file_size(Paths::logPath()) == whole);
+      CHECK(store.countPending() == 1);
+      CHECK(countedPending(store) == 1);
+      CHECK(store.add("c") == 3);
+    }
+    LogStore store;
+    CHECK(store.countPending() == 2);
+  }
+
+  // A whole frame whose CRC does not match, as a torn sector would leave.
+  void badCrcFrameIsTruncated() {
+    {
+      LogStore store;
+      store.add("a");
+      store.add("b");
+    }
+    const auto whole = std::filesystem::file_size(Paths::logPath());
+    // An add of task 3: type, id and time, then the text.
+    std::string payload;
+    put<std::uint8_t>(payload, 1);
+    put<std::int64_t>(payload, 3);
+    put<std::int64_t>(payload, 1700000000);
+    payload += "ghost";
+    std::string frame;
+    put<std::uint32_t>(frame, 0xDEADBEEF);
+    put<std::uint32_t>(frame, static_cast<std::uint32_t>(payload.size()));
+    appendToLog(frame + payload);
+
+    LogStore store;
+    CHECK(std::filesystem::file_size(Paths::logPath()) == whole);
+    CHECK(store.countPending() == 2);
+    CHECK(countedPending(store) == 2);
+    CHECK(store.add("c") == 3);
+    CHECK(store.countPending() == 3);
+  }
+
+  // The deleted highest id lives on only in the Sequence record.
+  void compactionKeepsIdsAndCompletionTimes() {
+    std::optional<Task> done;
+    {
+      LogStore store;
+      store.add("a");
+      store.add("b");
+      store.add("c");
+      done = store.completeById(2);
+      CHECK(store.remove(3));
+      store.compact();
+    }
+    CHECK(done && done->completedAt);
+
+    LogStore store;
+    CHECK(store.countPending() == 1);
+    const LogStore::Slot slot = slotOf(2);
+    CHECK(slot.state == 2);  // Completed
+    CHECK(done && slot.completedAt == *done->completedAt);
+    CHECK(store.add("d") == 4);
+  }
+
+  // Add-and-delete churn grows the log past COMPACT_MIN_BYTES (1 MiB) with
+  // almost nothing live, so a commit compacts it on its own.
+  void logPastMinimumCompactsItself() {
+    constexpr int CHURN = 1500;
+    const std::string text(1000, 'x');
+    std::optional<Task> done;
+    {
+      LogStore store;
+      store.add("kept");
+      done = store.completeById(1);
+      store.add("pending");
+      for (int i = 0; i < CHURN; i++) {
+        CHECK(store.remove(store.add(text)));
+      }
+    }
+    CHECK(std::filesystem::file_size(Paths::logPath()) < (1 << 20));
+
+    LogStore store;
+    CHECK(store.countPending() == 1);
+    const auto first = store.firstPending();
+    CHECK(first && first->id == 2 && first->text == "pending");
+    const LogStore::Slot slot = slotOf(1);
+    CHECK(slot.state == 2);  // Completed
+    CHECK(done && slot.completedAt == *done->completedAt);
+    CHECK(store.add("next") == CHURN + 3);
+  }
+
+  const test::Case<void (*)()> CASES[] = {
+    {"slots ahead of header after add", slotsAheadOfHeaderAfterAdd},
+    {"slots ahead of header after complete", slotsAheadOfHeaderAfterComplete},
+    {"slots ahead of header after delete", slotsAheadOfHeaderAfterDelete},
+    {"lost index is rebuilt", lostIndexIsRebuilt},
+    {"read-only stores share the lock", readOnlyStoresShareTheLock},
+    {"read-only open brings the index up to date", readOnlyOpenBringsTheIndexUpToDate},
+    {"partial frame is truncated", partialFrameIsTruncated},
+    {"frame with a bad CRC is truncated", badCrcFrameIsTruncated},
+    {"compaction keeps ids and completion times", compactionKeepsIdsAndCompletionTimes},
+    {"log past the minimum compacts itself", logPastMinimumCompactsItself},
+  };
+} // private namespace
+
+int main() {
+  test::ScratchHome home("nudge-log-recovery");
+
+  int failed = 0;
+  for (const auto& recovery : CASES) {
+    const bool ok = test::run(recovery.name, [&] {
+      std::filesystem::remove(Paths::logPath());
+      std::filesystem::remove(Paths::logIndexPath());
+      recovery.run();
+    });
+    failed += ok ? 0 : 1;
+  }
+  return test::summary(failed, static_cast<int>(std::size(CASES)));
+}
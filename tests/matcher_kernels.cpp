@@ -0,0 +1,214 @@
+// Checks nudge_contains()'s matcher against naive references: every ASCII
+// kernel the CPU supports on 300k generated inputs that straddle the 16- and
+// 32-byte block boundaries and tails, and the UTF-8 path's folding of Latin-1,
+// Latin Extended-A, Greek and Cyrillic letters.
+//
+// The generator is seeded, so a failure reproduces.
+
+#include <array>
+#include <print>
+#include <format>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <string_view>
+
+#include "matcher.hpp"
+#include "test_support.hpp"
+
+namespace {
+  constexpr int ASCII_INPUTS = 300000;
+  constexpr int UTF8_INPUTS = 20000;
+  constexpr std::size_t MAX_HAYSTACK = 100;
+  constexpr std::size_t MAX_NEEDLE = 40;
+
+  // The bytes around 'A'..'Z' and 'a'..'z' are where a wrong fold shows, and
+  // bytes >= 0x80 must never match an ASCII needle.
+  constexpr std::string_view ALPHABET = "@AZ[`az{ab0\x80\xC3\xFF";
+
+  char lowerAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+  }
+
+  bool referenceContains(std::string_view haystack, std::string_view lowerNeedle) {
+    for (std::size_t i = 0; i + lowerNeedle.size() <= haystack.size(); i++) {
+      std::size_t k = 0;
+      while (k < lowerNeedle.size() && lowerAscii(haystack[i + k]) == lowerNeedle[k]) {
+        k++;
+      }
+      if (k == lowerNeedle.size()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::string lowered(std::string s) {
+    for (char& c : s) {
+      c = lowerAscii(c);
+    }
+    return s;
+  }
+
+  // Sizes on both sides of every 16- and 32-byte boundary up to MAX_HAYSTACK.
+  std::size_t haystackSize(std::mt19937& random) {
+    static const std::vector<std::size_t> sizes = [] {
+      std::vector<std::size_t> out;
+      for (std::size_t block = 16; block <= MAX_HAYSTACK; block += 16) {
+        for (std::size_t size : {block - 2, block - 1, block, block + 1, block + 2}) {
+          out.push_back(size);
+        }
+      }
+      return out;
+    }();
+    if (random() % 2 == 0) {
+      return sizes[random() % sizes.size()];
+    }
+    return random() % (MAX_HAYSTACK + 1);
+  }
+
+  std::string randomAscii(std::mt19937& random, std::size_t size, std::string_view alphabet) {
+    std::string out(size, ' ');
+    for (char& c : out) {
+      c = alphabet[random() % alphabet.size()];
+    }
+    return out;
+  }
+
+  // Half the needles are planted at a random offset, often right at a tail, in
+  // random case; the rest are random and mostly absent.
+  void checkKernel(matcher::Kernel kernel, std::string_view name) {
+    std::mt19937 random(20240611);
+    int mismatches = 0;
+    for (int i = 0; i < ASCII_INPUTS; i++) {
+      std::string haystack = randomAscii(random, haystackSize(random), ALPHABET);
+      const std::size_t m = 1 + random() % MAX_NEEDLE;
+      std::string needle = randomAscii(random, m, "AZaz@[`{09");
+      if (random() % 2 == 0 && m <= haystack.size()) {
+        const std::size_t at = random() % 4 == 0 ? haystack.size() - m : random() % (haystack.size() - m + 1);
+        haystack.replace(at, m, needle);
+      }
+
+      const std::string lowerNeedle = lowered(needle);
+      const bool expected = referenceContains(haystack, lowerNeedle);
+      if (matcher::asciiContains(kernel, haystack, lowerNeedle) != expected) {
+        if (mismatches++ < 5) {
+          CHECK(false && "kernel disagrees with the reference");
+          std::println(stderr, "  {}: haystack of {} bytes, needle \"{}\", expected {}", name, haystack.size(),
+                       lowerNeedle, expected);
+        }
+      }
+    }
+    CHECK(mismatches == 0);
+  }
+
+  // Needles at every offset of haystacks of 1..96 bytes, so each block and
+  // tail position is hit deterministically as well.
+  void checkEveryOffset(matcher::Kernel kernel) {
+    for (std::size_t size = 1; size <= 96; size++) {
+      const std::string haystack(size, 'x');
+      for (std::size_t m : {1, 2, 3, 16, 17, 31, 32, 33}) {
+        for (std::size_t at = 0; at + m <= size; at++) {
+          std::string text = haystack;
+          text.replace(at, m, std::string(m - 1, 'Q') + "Z");
+          const std::string needle = std::string(m - 1, 'q') + "z";
+          CHECK(matcher::asciiContains(kernel, text, needle));
+          text[at + m - 1] = 'y';
+          CHECK(!matcher::asciiContains(kernel, text, needle));
+        }
+      }
+    }
+  }
+
+  const std::array<std::pair<matcher::Kernel, std::string_view>, 3> KERNELS = {{
+    {matcher::Kernel::Scalar, "scalar"},
+    {matcher::Kernel::Sse2, "sse2"},
+    {matcher::Kernel::Avx2, "avx2"},
+  }};
+
+  // Upper- and lower-case forms of letters from each script the UTF-8 path folds.
+  struct Letter {
+    std::string_view upper;
+    std::string_view lower;
+  };
+
+  constexpr Letter LETTERS[] = {
+    {"A", "a"}, {"Q", "q"}, {"Z", "z"},
+    {"À", "à"}, {"É", "é"}, {"Ö", "ö"}, {"Þ", "þ"}, {"Ÿ", "ÿ"},   // Latin-1 Supplement
+    {"Ā", "ā"}, {"Ł", "ł"}, {"Ń", "ń"}, {"Ž", "ž"},                  // Latin Extended-A
+    {"Α", "α"}, {"Λ", "λ"}, {"Σ", "σ"}, {"Ω", "ω"},                  // Greek
+    {"Ё", "ё"}, {"Ж", "ж"}, {"П", "п"}, {"Я", "я"},                  // Cyrillic
+    {"1", "1"}, {" ", " "}, {"×", "×"}, {"ß", "ß"}, {"€", "€"},      // no case
+  };
+
+  void checkUtf8Folding() {
+    // Fixed cases from each script.
+    CHECK(matcher::containsIgnoreCase("ÉCOLE PRIMAIRE", "école"));
+    CHECK(matcher::containsIgnoreCase("Ärger mit ÖL", "öl"));
+    CHECK(matcher::containsIgnoreCase("ŁÓDŹ trip", "łódź"));
+    CHECK(matcher::containsIgnoreCase("ΚΑΛΗΜΕΡΑ κόσμε", "καλημερα"));
+    CHECK(matcher::containsIgnoreCase("ПОЗВОНИТЬ маме", "позвонить"));
+    CHECK(matcher::containsIgnoreCase("ЁЛКА", "ёлка"));
+    CHECK(!matcher::containsIgnoreCase("straße", "STRASSE"));
+    CHECK(!matcher::containsIgnoreCase("ΚΑΛΗΜΕΡΑ", "καλησπερα"));
+
+    // Random words over LETTERS: a needle matches exactly when its sequence of
+    // letters occurs in the haystack's, whatever the case of either.
+    std::mt19937 random(20240612);
+    int mismatches = 0;
+    for (int i = 0; i < UTF8_INPUTS; i++) {
+      const std::size_t size = random() % 40;
+      std::vector<std::size_t> haystack(size);
+      for (auto& letter : haystack) {
+        letter = random() % std::size(LETTERS);
+      }
+      std::vector<std::size_t> needle(1 + random() % 6);
+      for (auto& letter : needle) {
+        letter = random() % std::size(LETTERS);
+      }
+      if (random() % 2 == 0 && needle.size() <= size) {
+        std::copy(needle.begin(), needle.end(), haystack.begin() + random() % (size - needle.size() + 1));
+      }
+
+      bool expected = false;
+      for (std::size_t at = 0; !expected && at + needle.size() <= size; at++) {
+        expected = std::equal(needle.begin(), needle.end(), haystack.begin() + at);
+      }
+
+      auto spell = [&](const std::vector<std::size_t>& letters) {
+        std::string out;
+        for (std::size_t letter : letters) {
+          out += random() % 2 ? LETTERS[letter].upper : LETTERS[letter].lower;
+        }
+        return out;
+      };
+      const std::string text = spell(haystack);
+      const std::string pattern = spell(needle);
+      if (matcher::containsIgnoreCase(text, pattern) != expected && mismatches++ < 5) {
+        CHECK(false && "UTF-8 folding disagrees with the reference");
+        std::println(stderr, "  \"{}\" in \"{}\", expected {}", pattern, text, expected);
+      }
+    }
+    CHECK(mismatches == 0);
+  }
+} // private namespace
+
+int main() {
+  int failed = 0;
+  int total = 0;
+  for (const auto& [kernel, name] : KERNELS) {
+    if (!matcher::kernelSupported(kernel)) {
+      std::println("skip {} kernel: not supported on this CPU", name);
+      continue;
+    }
+    total += 2;
+    failed += test::run(std::format("{} kernel against the reference", name), [&] { checkKernel(kernel, name); }) ? 0 : 1;
+    failed += test::run(std::format("{} kernel at every offset", name), [&] { checkEveryOffset(kernel); }) ? 0 : 1;
+  }
+  total++;
+  failed += test::run("UTF-8 folding", checkUtf8Folding) ? 0 : 1;
+  return test::summary(failed, total);
+}
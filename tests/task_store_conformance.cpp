@@ -0,0 +1,212 @@
+// Runs the same TaskStore cases against every backend, so SqliteStore,
+// MemoryStore and LogStore cannot drift apart. Registered with CTest:
+//
+//   cmake -S . -B build && cmake --build build && ctest --test-dir build
+//
+// HOME points at a scratch directory; each case starts from an empty store.
+
+#include <format>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+
+#include "paths.hpp"
+#include "database.hpp"
+#include "task_store.hpp"
+#include "sqlite_store.hpp"
+#include "memory_store.hpp"
+#include "log_store.hpp"
+#include "test_support.hpp"
+
+namespace {
+  // Ids a visitor was called with, sorted: backends may visit in any order.
+  struct Visited {
+    std::vector<long long> ids;
+    TaskVisitor visitor() {
+      return [this](const Task& task) { ids.push_back(task.id); };
+    }
+    std::vector<long long> sorted() const {
+      auto copy = ids;
+      std::ranges::sort(copy);
+      return copy;
+    }
+  };
+
+  std::vector<long long> pendingIds(TaskStore& store) {
+    Visited visited;
+    store.forEachPending(visited.visitor());
+    return visited.ids;
+  }
+
+  void removeFiles(std::initializer_list<std::filesystem::path> paths) {
+    for (const auto& path : paths) {
+      for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::filesystem::remove(path.string() + suffix);
+      }
+    }
+  }
+
+  // A store that starts empty. `session` keeps alive whatever the store runs on
+  // and is destroyed after it.
+  struct Backend {
+    std::string_view name;
+    std::function<std::unique_ptr<TaskStore>(std::unique_ptr<Database>& session)> open;
+  };
+
+  const Backend BACKENDS[] = {
+    {"sqlite", [](std::unique_ptr<Database>& session) -> std::unique_ptr<TaskStore> {
+       removeFiles({Paths::dbPath()});
+       session = std::make_unique<Database>();
+       database::setupTables(*session);
+       return std::make_unique<SqliteStore>(*session);
+     }},
+    {"memory", [](std::unique_ptr<Database>&) -> std::unique_ptr<TaskStore> {
+       return std::make_unique<MemoryStore>();
+     }},
+    {"log", [](std::unique_ptr<Database>&) -> std::unique_ptr<TaskStore> {
+       removeFiles({Paths::logPath(), Paths::logIndexPath()});
+       return std::make_unique<LogStore>();
+     }},
+  };
+
+  void addAssignsIncreasingIds(TaskStore& store) {
+    CHECK(store.countPending() == 0);
+    CHECK(!store.firstPending().has_value());
+    const long long a = store.add("alpha");
+    const long long b = store.add("beta");
+    CHECK(a == 1);
+    CHECK(b == 2);
+    CHECK(store.countPending() == 2);
+  }
+
+  void listsPendingNewestFirst(TaskStore& store) {
+    store.add("one");
+    store.add("two");
+    store.add("three");
+    CHECK(pendingIds(store) == (std::vector<long long>{3, 2, 1}));
+
+    const auto first = store.firstPending();
+    CHECK(first && first->id == 1 && first->text == "one" && first->status == TaskStatus::Pending);
+    CHECK(first && !first->completedAt && first->createdAt > 0);
+  }
+
+  void removeOnlyTouchesPendingTasks(TaskStore& store) {
+    store.add("keep");
+    store.add("drop");
+    store.add("done");
+    CHECK(store.completeById(3).has_value());
+
+    CHECK(store.remove(2));
+    CHECK(!store.remove(2));
+    CHECK(!store.remove(3));
+    CHECK(!store.remove(99));
+    CHECK(store.countPending() == 1);
+    CHECK(pendingIds(store) == (std::vector<long long>{1}));
+  }
+
+  void idsAreNotReused(TaskStore& store) {
+    store.add("a");
+    store.add("b");
+    CHECK(store.remove(2));
+    CHECK(store.add("c") == 3);
+  }
+
+  void completeByIdReturnsTheTask(TaskStore& store) {
+    store.add("write report");
+    const auto done = store.completeById(1);
+    CHECK(done && done->id == 1 && done->text == "write report");
+    CHECK(done && done->status == TaskStatus::Completed && done->completedAt);
+    CHECK(!store.completeById(1).has_value());
+    CHECK(!store.completeById(42).has_value());
+    CHECK(store.countPending() == 0);
+    CHECK(!store.firstPending().has_value());
+  }
+
+  void completeByIdsSkipsSettledAndUnknownIds(TaskStore& store) {
+    for (int i = 0; i < 5; i++) {
+      store.add(std::format("task {}", i));
+    }
+    CHECK(store.completeById(2).has_value());
+    CHECK(store.remove(4));
+
+    const long long ids[] = {1, 2, 3, 4, 77};
+    Visited visited;
+    CHECK(store.completeByIds(ids, visited.visitor()) == 2);
+    CHECK(visited.sorted() == (std::vector<long long>{1, 3}));
+    CHECK(pendingIds(store) == (std::vector<long long>{5}));
+    CHECK(store.countPending() == 1);
+  }
+
+  void completeMatchingIgnoresCase(TaskStore& store) {
+    store.add("Buy MILK");
+    store.add("call mum");
+    store.add("milkshake");
+    store.add("bread");
+
+    Visited visited;
+    CHECK(store.completeMatching("milk", visited.visitor()) == 2);
+    CHECK(visited.sorted() == (std::vector<long long>{1, 3}));
+    CHECK(store.completeMatching("milk", [](const Task&) {}) == 0);
+    CHECK(pendingIds(store) == (std::vector<long long>{4, 2}));
+  }
+
+  void completeOlderThanUsesCreationTime(TaskStore& store) {
+    store.add("a");
+    store.add("b");
+    store.add("c");
+    CHECK(store.remove(2));
+
+    // Everything here was created just now: nothing is an hour old, and
+    // everything is older than a second in the future.
+    CHECK(store.completeOlderThan(3600, [](const Task&) {}) == 0);
+    Visited visited;
+    CHECK(store.completeOlderThan(-1, visited.visitor()) == 2);
+    CHECK(visited.sorted() == (std::vector<long long>{1, 3}));
+    CHECK(store.countPending() == 0);
+  }
+
+  void textIsKeptExactly(TaskStore& store) {
+    const std::string text = "  tabs\tand \"quotes\", commas, ünïcödé and a very long tail " + std::string(500, 'x');
+    store.add(text);
+    store.add("");
+    const auto first = store.firstPending();
+    CHECK(first && first->text == text);
+
+    std::vector<std::string> texts;
+    store.forEachPending([&](const Task& task) { texts.push_back(task.text); });
+    CHECK(texts == (std::vector<std::string>{"", text}));
+  }
+
+  const test::Case<void (*)(TaskStore&)> CASES[] = {
+    {"add assigns increasing ids", addAssignsIncreasingIds},
+    {"lists pending newest first", listsPendingNewestFirst},
+    {"remove only touches pending tasks", removeOnlyTouchesPendingTasks},
+    {"ids are not reused", idsAreNotReused},
+    {"completeById returns the task", completeByIdReturnsTheTask},
+    {"completeByIds skips settled and unknown ids", completeByIdsSkipsSettledAndUnknownIds},
+    {"completeMatching ignores case", completeMatchingIgnoresCase},
+    {"completeOlderThan uses creation time", completeOlderThanUsesCreationTime},
+    {"text is kept exactly", textIsKeptExactly},
+  };
+} // private namespace
+
+int main() {
+  test::ScratchHome home("nudge-conformance");
+
+  int failed = 0;
+  for (const auto& backend : BACKENDS) {
+    for (const auto& conformance : CASES) {
+      const bool ok = test::run(std::format("{}: {}", backend.name, conformance.name), [&] {
+        std::unique_ptr<Database> session;
+        auto store = backend.open(session);
+        conformance.run(*store);
+      });
+      failed += ok ? 0 : 1;
+    }
+  }
+  return test::summary(failed, static_cast<int>(std::size(BACKENDS) * std::size(CASES)));
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <print>
+#include <format>
+#include <string>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+
+#include "paths.hpp"
+
+// What every program in tests/ shares: CHECK, named cases that report
+// ok/FAIL, and a scratch HOME so Paths never points at the user's files.
+// Each test is its own executable registered with CTest; it returns
+// test::summary() from main().
+namespace test {
+  inline int failures = 0;
+
+  inline void check(bool ok, std::string_view what, int line) {
+    if (!ok) {
+      std::println(stderr, "  line {}: CHECK({}) failed", line, what);
+      failures++;
+    }
+  }
+
+  // A case in a test's table; `Run` is the signature its cases share.
+  template <typename Run>
+  struct Case {
+    std::string_view name;
+    Run run;
+  };
+
+  // Runs one case and prints its outcome. A failed CHECK or an exception fails it.
+  inline bool run(std::string_view name, const std::function<void()>& body) {
+    const int before = failures;
+    try {
+      body();
+    } catch (const std::exception& e) {
+      std::println(stderr, "  threw: {}", e.what());
+      failures++;
+    }
+    const bool ok = failures == before;
+    std::println("{} {}", ok ? "ok  " : "FAIL", name);
+    return ok;
+  }
+
+  inline int summary(int failed, int total) {
+    std::println("{} of {} cases failed", failed, total);
+    return failed == 0 ? 0 : 1;
+  }
+
+  // Points HOME at a fresh directory holding an empty ~/.nudge for the life
+  // of the object. Paths caches its locations, so make one before using them.
+  class ScratchHome {
+    public:
+      explicit ScratchHome(std::string_view name) {
+        std::string pattern = (std::filesystem::temp_directory_path() / std::format("{}-XXXXXX", name)).string();
+        if (!mkdtemp(pattern.data())) {
+          std::println(stderr, "Cannot create a scratch directory");
+          std::exit(1);
+        }
+        path = pattern;
+        setenv("HOME", path.c_str(), 1);
+        std::filesystem::create_directories(Paths::configDirectoryPath());
+      }
+
+      ~ScratchHome() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+      }
+
+      ScratchHome(const ScratchHome&) = delete;
+      ScratchHome& operator=(const ScratchHome&) = delete;
+
+    private:
+      std::filesystem::path path;
+  };
+} // test
+
+#define CHECK(condition) test::check((condition), #condition, __LINE__)